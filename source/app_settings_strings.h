@@ -19,4 +19,22 @@
 #define APP_SKIP_SUBTUNES_DEFAULT               false
 
 #define KEY_APP_ALWAYS_START_FIRST_TUNE         "app-alwaysStartFirstTune"
-#define APP_ALWAYS_START_FIRST_TUNE_DEFAULT     false
\ No newline at end of file
+#define APP_ALWAYS_START_FIRST_TUNE_DEFAULT     false
+
+#define KEY_APP_READ_AHEAD                      "app-readAhead"
+#define APP_READ_AHEAD_DEFAULT                  1
+
+#define KEY_APP_VOLUME                          "app-volume"
+#define APP_VOLUME_DEFAULT                      100
+
+#define KEY_APP_LOUDNESS_NORMALIZATION          "app-loudnessNormalization"
+#define APP_LOUDNESS_NORMALIZATION_DEFAULT      true
+
+#define KEY_APP_CROSSFADE                       "app-crossfade"
+#define APP_CROSSFADE_DEFAULT                   0
+
+#define KEY_APP_LOW_LATENCY                     "app-lowLatency"
+#define APP_LOW_LATENCY_DEFAULT                 false
+
+#define KEY_APP_LIBRARY_INDEXING                "app-libraryIndexing"
+#define APP_LIBRARY_INDEXING_DEFAULT            false
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "audiometrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <SDL2/SDL_timer.h>
+
+AudioMetrics::AudioMetrics() :
+    mCounterFrequency(SDL_GetPerformanceFrequency()),
+    mCallbackPeriod(0.0f),
+    mReadAhead(0.0f) {
+
+    reset();
+}
+
+AudioMetrics::~AudioMetrics() {
+}
+
+Uint64 AudioMetrics::now() {
+    return SDL_GetPerformanceCounter();
+}
+
+void AudioMetrics::setCallbackPeriod(const int frames, const int frequency) {
+    mCallbackPeriod = frequency > 0 ? frames * 1000000.0f / frequency : 0.0f;
+}
+
+void AudioMetrics::setReadAhead(const float readAheadMs) {
+    mReadAhead = readAheadMs;
+}
+
+void AudioMetrics::reset() {
+    // Writers may still be running, a few values can survive the reset
+    mCallbacks = 0;
+    mUnderruns = 0;
+    mDroppedBuffers = 0;
+    mDecodedChunks = 0;
+    mLastCallbackStart = 0;
+    mMaxCallbackTime = 0.0f;
+    mMaxCallbackJitter = 0.0f;
+    mMaxProcessTime = 0.0f;
+    mCommands = 0;
+    mLastCommandLatency = 0.0f;
+    mMaxCommandLatency = 0.0f;
+    mDecodedTime = 0;
+    mProcessTime = 0;
+
+    for (auto i=0; i<HISTORY_SIZE; i++) {
+        mCallbackTimes[i] = 0.0f;
+        mCallbackJitters[i] = 0.0f;
+        mBufferFills[i] = 0.0f;
+        mProcessTimes[i] = 0.0f;
+    }
+    mCallbackPosition = 0;
+    mProcessPosition = 0;
+
+    for (auto i=0; i<HISTOGRAM_SIZE; i++) {
+        mCallbackHistogram[i] = 0;
+        mProcessHistogram[i] = 0;
+    }
+}
+
+void AudioMetrics::addCallback(const Uint64 start, const Uint64 end, const float bufferFill, const bool underrun) {
+    const auto time = toMicroseconds(start, end);
+
+    // Distance to the expected interval between two callbacks
+    auto jitter = 0.0f;
+    if (const auto lastStart = mLastCallbackStart.exchange(start, std::memory_order_relaxed);
+        lastStart != 0 && lastStart < start) {
+
+        jitter = std::abs(toMicroseconds(lastStart, start) - mCallbackPeriod);
+    }
+
+    const auto position = mCallbackPosition.load(std::memory_order_relaxed) % HISTORY_SIZE;
+    mCallbackTimes[position].store(time, std::memory_order_relaxed);
+    mCallbackJitters[position].store(jitter, std::memory_order_relaxed);
+    mBufferFills[position].store(bufferFill, std::memory_order_relaxed);
+    mCallbackPosition.store(position + 1, std::memory_order_release);
+
+    mCallbackHistogram[getBucket(time)].fetch_add(1, std::memory_order_relaxed);
+    updateMax(mMaxCallbackTime, time);
+    updateMax(mMaxCallbackJitter, jitter);
+    mCallbacks.fetch_add(1, std::memory_order_relaxed);
+    if (underrun) {
+        mUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AudioMetrics::addProcess(const Uint64 start, const Uint64 end, const size_t frames, const int frequency) {
+    const auto time = toMicroseconds(start, end);
+
+    const auto position = mProcessPosition.load(std::memory_order_relaxed) % HISTORY_SIZE;
+    mProcessTimes[position].store(time, std::memory_order_relaxed);
+    mProcessPosition.store(position + 1, std::memory_order_release);
+
+    mProcessHistogram[getBucket(time)].fetch_add(1, std::memory_order_relaxed);
+    updateMax(mMaxProcessTime, time);
+    mDecodedChunks.fetch_add(1, std::memory_order_relaxed);
+    if (frequency > 0) {
+        mDecodedTime.fetch_add(frames * 1000000 / frequency, std::memory_order_relaxed);
+    }
+    mProcessTime.fetch_add((Uint64) time, std::memory_order_relaxed);
+}
+
+void AudioMetrics::addDroppedBuffer() {
+    mDroppedBuffers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioMetrics::addCommandLatency(const Uint64 start, const Uint64 end) {
+    const auto latency = toMicroseconds(start, end);
+    mLastCommandLatency.store(latency, std::memory_order_relaxed);
+    updateMax(mMaxCommandLatency, latency);
+    mCommands.fetch_add(1, std::memory_order_release);
+}
+
+Uint64 AudioMetrics::getUnderruns() const {
+    return mUnderruns.load(std::memory_order_relaxed);
+}
+
+float AudioMetrics::getMaxProcessTime() const {
+    return mMaxProcessTime.load(std::memory_order_relaxed);
+}
+
+Uint64 AudioMetrics::getCommandCount() const {
+    return mCommands.load(std::memory_order_acquire);
+}
+
+float AudioMetrics::getLastCommandLatency() const {
+    return mLastCommandLatency.load(std::memory_order_relaxed);
+}
+
+void AudioMetrics::getSnapshot(Snapshot& snapshot) const {
+    snapshot.callbacks = mCallbacks;
+    snapshot.underruns = mUnderruns;
+    snapshot.droppedBuffers = mDroppedBuffers;
+    snapshot.decodedChunks = mDecodedChunks;
+    snapshot.callbackPeriod = mCallbackPeriod;
+    snapshot.maxCallbackTime = mMaxCallbackTime;
+    snapshot.maxCallbackJitter = mMaxCallbackJitter;
+    snapshot.maxProcessTime = mMaxProcessTime;
+    snapshot.readAhead = mReadAhead;
+    snapshot.commands = mCommands;
+    snapshot.lastCommandLatency = mLastCommandLatency;
+    snapshot.maxCommandLatency = mMaxCommandLatency;
+
+    const Uint64 processTime = mProcessTime;
+    snapshot.realtimeFactor = processTime > 0 ? (float) mDecodedTime / processTime : 0.0f;
+
+    const auto callbackPosition = mCallbackPosition.load(std::memory_order_acquire);
+    const auto processPosition = mProcessPosition.load(std::memory_order_acquire);
+    for (auto i=0; i<HISTORY_SIZE; i++) {
+        const auto callbackIndex = (callbackPosition + i) % HISTORY_SIZE;
+        snapshot.callbackTimes[i] = mCallbackTimes[callbackIndex].load(std::memory_order_relaxed);
+        snapshot.callbackJitters[i] = mCallbackJitters[callbackIndex].load(std::memory_order_relaxed);
+        snapshot.bufferFills[i] = mBufferFills[callbackIndex].load(std::memory_order_relaxed);
+        snapshot.processTimes[i] = mProcessTimes[(processPosition + i) % HISTORY_SIZE].load(std::memory_order_relaxed);
+    }
+
+    for (auto i=0; i<HISTOGRAM_SIZE; i++) {
+        snapshot.callbackHistogram[i] = mCallbackHistogram[i].load(std::memory_order_relaxed);
+        snapshot.processHistogram[i] = mProcessHistogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+bool AudioMetrics::dump(const std::filesystem::path path) const {
+    std::ofstream os(path);
+    if (!os.is_open()) {
+        return false;
+    }
+
+    Snapshot snapshot;
+    getSnapshot(snapshot);
+
+    os << "callbacks " << snapshot.callbacks << "\n";
+    os << "underruns " << snapshot.underruns << "\n";
+    os << "dropped_buffers " << snapshot.droppedBuffers << "\n";
+    os << "decoded_chunks " << snapshot.decodedChunks << "\n";
+    os << "callback_period_us " << snapshot.callbackPeriod << "\n";
+    os << "max_callback_us " << snapshot.maxCallbackTime << "\n";
+    os << "max_callback_jitter_us " << snapshot.maxCallbackJitter << "\n";
+    os << "max_process_us " << snapshot.maxProcessTime << "\n";
+    os << "realtime_factor " << snapshot.realtimeFactor << "\n";
+    os << "read_ahead_ms " << snapshot.readAhead << "\n";
+    os << "commands " << snapshot.commands << "\n";
+    os << "last_command_latency_us " << snapshot.lastCommandLatency << "\n";
+    os << "max_command_latency_us " << snapshot.maxCommandLatency << "\n";
+
+    os << "\n# bucket_start_us callbacks process_calls\n";
+    for (auto i=0; i<HISTOGRAM_SIZE; i++) {
+        os << getBucketStart(i) << " " << snapshot.callbackHistogram[i] << " " << snapshot.processHistogram[i] << "\n";
+    }
+
+    os << "\n# callback_us jitter_us buffer_fill_percent process_us, oldest first\n";
+    for (auto i=0; i<HISTORY_SIZE; i++) {
+        os << snapshot.callbackTimes[i] << " " << snapshot.callbackJitters[i] << " "
+            << snapshot.bufferFills[i] << " " << snapshot.processTimes[i] << "\n";
+    }
+
+    return os.good();
+}
+
+int AudioMetrics::getBucketStart(const int bucket) {
+    return bucket == 0 ? 0 : 1 << (bucket - 1);
+}
+
+float AudioMetrics::toMicroseconds(const Uint64 start, const Uint64 end) const {
+    return (end - start) * 1000000.0f / mCounterFrequency;
+}
+
+int AudioMetrics::getBucket(const float time) {
+    // [0, 1[, [1, 2[, [2, 4[ ... the last one takes everything above
+    auto bucket = 0;
+    for (auto limit = 1.0f; bucket < HISTOGRAM_SIZE - 1 && time >= limit; limit *= 2.0f) {
+        bucket++;
+    }
+    return bucket;
+}
+
+void AudioMetrics::updateMax(std::atomic<float>& max, const float value) {
+    auto current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
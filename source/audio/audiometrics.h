@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <SDL2/SDL_stdinc.h>
+
+// Lock free telemetry of the audio path. The audio callback and the decoder
+// thread each write their own values, the UI reads a snapshot at any time.
+// Durations are in microseconds, histograms use power of two buckets.
+class AudioMetrics {
+
+    public:
+        static const int HISTOGRAM_SIZE = 16;
+        static const int HISTORY_SIZE = 256;
+
+        struct Snapshot {
+            Uint64 callbacks = 0;
+            Uint64 underruns = 0;
+            Uint64 droppedBuffers = 0;
+            Uint64 decodedChunks = 0;
+            float callbackPeriod = 0.0f;
+            float maxCallbackTime = 0.0f;
+            float maxCallbackJitter = 0.0f;
+            float maxProcessTime = 0.0f;
+            float realtimeFactor = 0.0f;
+            float readAhead = 0.0f;
+            Uint64 commands = 0;
+            float lastCommandLatency = 0.0f;
+            float maxCommandLatency = 0.0f;
+
+            // Oldest first
+            float callbackTimes[HISTORY_SIZE] = {};
+            float callbackJitters[HISTORY_SIZE] = {};
+            float bufferFills[HISTORY_SIZE] = {};
+            float processTimes[HISTORY_SIZE] = {};
+
+            float callbackHistogram[HISTOGRAM_SIZE] = {};
+            float processHistogram[HISTOGRAM_SIZE] = {};
+        };
+
+        AudioMetrics();
+        virtual ~AudioMetrics();
+
+        void setCallbackPeriod(const int frames, const int frequency);
+        void setReadAhead(const float readAheadMs);
+        void reset();
+
+        static Uint64 now();
+
+        // Audio callback side, bufferFill in percent
+        void addCallback(const Uint64 start, const Uint64 end, const float bufferFill, const bool underrun);
+
+        // Decoder thread side
+        void addProcess(const Uint64 start, const Uint64 end, const size_t frames, const int frequency);
+        void addDroppedBuffer();
+
+        // Time from a command to the first non silent sample sent to the device
+        void addCommandLatency(const Uint64 start, const Uint64 end);
+
+        Uint64 getUnderruns() const;
+        float getMaxProcessTime() const;
+        Uint64 getCommandCount() const;
+        float getLastCommandLatency() const;
+
+        void getSnapshot(Snapshot& snapshot) const;
+        bool dump(const std::filesystem::path path) const;
+
+        // Lower bound of a histogram bucket
+        static int getBucketStart(const int bucket);
+
+    private:
+        const Uint64 mCounterFrequency;
+        std::atomic<float> mCallbackPeriod;
+        std::atomic<float> mReadAhead;
+
+        std::atomic<Uint64> mCallbacks;
+        std::atomic<Uint64> mUnderruns;
+        std::atomic<Uint64> mDroppedBuffers;
+        std::atomic<Uint64> mDecodedChunks;
+        std::atomic<Uint64> mLastCallbackStart;
+        std::atomic<float> mMaxCallbackTime;
+        std::atomic<float> mMaxCallbackJitter;
+        std::atomic<float> mMaxProcessTime;
+        std::atomic<Uint64> mCommands;
+        std::atomic<float> mLastCommandLatency;
+        std::atomic<float> mMaxCommandLatency;
+
+        // Sound rendered against time spent, in microseconds
+        std::atomic<Uint64> mDecodedTime;
+        std::atomic<Uint64> mProcessTime;
+
+        std::atomic<float> mCallbackTimes[HISTORY_SIZE];
+        std::atomic<float> mCallbackJitters[HISTORY_SIZE];
+        std::atomic<float> mBufferFills[HISTORY_SIZE];
+        std::atomic<Uint32> mCallbackPosition;
+        std::atomic<float> mProcessTimes[HISTORY_SIZE];
+        std::atomic<Uint32> mProcessPosition;
+
+        std::atomic<Uint32> mCallbackHistogram[HISTOGRAM_SIZE];
+        std::atomic<Uint32> mProcessHistogram[HISTOGRAM_SIZE];
+
+        AudioMetrics(const AudioMetrics& copy);
+
+        float toMicroseconds(const Uint64 start, const Uint64 end) const;
+
+        static int getBucket(const float time);
+        static void updateMax(std::atomic<float>& max, const float value);
+
+};
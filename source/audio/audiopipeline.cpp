@@ -0,0 +1,146 @@
+#include "audiopipeline.h"
+
+#include "samplekernels.h"
+
+#include <cmath>
+#include <cstring>
+
+AudioPipeline::AudioPipeline() :
+    mInputFormat(AUDIO_S16SYS),
+    mOutputFormat(AUDIO_S16SYS),
+    mChannels(0),
+    mInputFrequency(0),
+    mOutputFrequency(0),
+    mVolume(1.0f),
+    mTrackGain(1.0f),
+    mAppliedGain(1.0f) {
+}
+
+AudioPipeline::~AudioPipeline() {
+}
+
+bool AudioPipeline::isFormatSupported(const SDL_AudioFormat format) {
+    return format == AUDIO_S16SYS || format == AUDIO_F32SYS;
+}
+
+bool AudioPipeline::setup(const SDL_AudioFormat inputFormat, const int inputChannels, const int inputFrequency,
+    const SDL_AudioFormat outputFormat, const int outputChannels, const int outputFrequency) {
+
+    if (!isFormatSupported(inputFormat) || !isFormatSupported(outputFormat)
+        || inputChannels != outputChannels || inputChannels <= 0) {
+
+        return false;
+    }
+
+    mInputFormat = inputFormat;
+    mOutputFormat = outputFormat;
+
+    // Same stream parameters: keep the filters state for a gapless transition
+    if (inputChannels == mChannels && inputFrequency == mInputFrequency && outputFrequency == mOutputFrequency) {
+        return true;
+    }
+
+    mChannels = inputChannels;
+    mInputFrequency = inputFrequency;
+    mOutputFrequency = outputFrequency;
+    if (!mResampler.setup(inputFrequency, outputFrequency, mChannels)) {
+        return false;
+    }
+    mLimiter.setup(outputFrequency, mChannels);
+    return true;
+}
+
+void AudioPipeline::reset() {
+    mResampler.reset();
+    mLimiter.reset();
+}
+
+void AudioPipeline::setVolume(const float volume) {
+    mVolume = volume;
+}
+
+void AudioPipeline::setTrackGain(const float gainDb) {
+    mTrackGain = std::pow(10.0f, gainDb / 20.0f);
+}
+
+int AudioPipeline::getInputFrameSize() const {
+    return mChannels * (SDL_AUDIO_BITSIZE(mInputFormat) / 8);
+}
+
+int AudioPipeline::getOutputFrameSize() const {
+    return mChannels * (SDL_AUDIO_BITSIZE(mOutputFormat) / 8);
+}
+
+int AudioPipeline::getInputFrequency() const {
+    return mInputFrequency;
+}
+
+size_t AudioPipeline::getInputFrames(const size_t outputFrames) const {
+    return mResampler.getInputFrames(outputFrames);
+}
+
+size_t AudioPipeline::getMaxOutputFrames(const size_t inputFrames) const {
+    return mResampler.getMaxOutputFrames(inputFrames);
+}
+
+size_t AudioPipeline::getDrainFrames() const {
+    // Enough for the resampler taps and the limiter delay at the input rate
+    return mResampler.getInputFrames(mLimiter.getLatency()) + 64;
+}
+
+size_t AudioPipeline::process(const Uint8* input, const size_t len, Uint8* output) {
+    if (mChannels == 0) {
+        return 0;
+    }
+
+    const auto inputFrames = len / getInputFrameSize();
+    const auto samples = inputFrames * mChannels;
+    mInputBuffer.resize(samples);
+
+    if (mInputFormat == AUDIO_F32SYS) {
+        memcpy(mInputBuffer.data(), input, samples * sizeof(float));
+    } else {
+        SampleKernels::convertS16ToFloat((const Sint16*) input, mInputBuffer.data(), samples);
+    }
+
+    return processFloat(mInputBuffer.data(), inputFrames, output);
+}
+
+size_t AudioPipeline::drain(Uint8* output) {
+    if (mChannels == 0) {
+        return 0;
+    }
+
+    const auto inputFrames = getDrainFrames();
+    mInputBuffer.assign(inputFrames * mChannels, 0.0f);
+    return processFloat(mInputBuffer.data(), inputFrames, output);
+}
+
+size_t AudioPipeline::processFloat(const float* input, const size_t inputFrames, Uint8* output) {
+    if (mChannels == 0) {
+        return 0;
+    }
+
+    mOutputBuffer.resize(getMaxOutputFrames(inputFrames) * mChannels);
+    const auto frames = mResampler.process(input, inputFrames, mOutputBuffer.data());
+    const auto samples = frames * mChannels;
+
+    // Ramp on gain changes to avoid clicks
+    const float gain = mVolume * mTrackGain;
+    if (gain != mAppliedGain) {
+        SampleKernels::applyGainRamp(mOutputBuffer.data(), frames, mChannels, mAppliedGain, gain);
+        mAppliedGain = gain;
+    } else if (gain != 1.0f) {
+        SampleKernels::applyGain(mOutputBuffer.data(), samples, gain);
+    }
+
+    mLimiter.process(mOutputBuffer.data(), frames);
+
+    if (mOutputFormat == AUDIO_F32SYS) {
+        memcpy(output, mOutputBuffer.data(), samples * sizeof(float));
+    } else {
+        SampleKernels::convertFloatToS16(mOutputBuffer.data(), (Sint16*) output, samples);
+    }
+
+    return frames * getOutputFrameSize();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "resampler.h"
+#include "limiter.h"
+
+#include <atomic>
+#include <vector>
+#include <SDL2/SDL_audio.h>
+
+// Float blocks processing between a decoder and the audio device:
+// sample format conversion, resampling, master volume and track gain,
+// then a look-ahead limiter so gains over unity never clip.
+// Decoder and device must have the same channels count.
+class AudioPipeline {
+
+    public:
+        AudioPipeline();
+        virtual ~AudioPipeline();
+
+        bool setup(const SDL_AudioFormat inputFormat, const int inputChannels, const int inputFrequency,
+            const SDL_AudioFormat outputFormat, const int outputChannels, const int outputFrequency);
+        void reset();
+
+        // Can be called from any thread, applied on the next block
+        void setVolume(const float volume);
+        void setTrackGain(const float gainDb);
+
+        int getInputFrameSize() const;
+        int getOutputFrameSize() const;
+        int getInputFrequency() const;
+        size_t getInputFrames(const size_t outputFrames) const;
+        size_t getMaxOutputFrames(const size_t inputFrames) const;
+
+        // Return the amount of bytes written to output, output must be able to hold
+        // getMaxOutputFrames() frames for the given input.
+        size_t process(const Uint8* input, const size_t len, Uint8* output);
+        // Same with input already in float, as mixed by the crossfade
+        size_t processFloat(const float* input, const size_t inputFrames, Uint8* output);
+
+        // Push silence through to get what the resampler and limiter still hold,
+        // output must be able to hold getMaxOutputFrames(getDrainFrames()) frames.
+        size_t getDrainFrames() const;
+        size_t drain(Uint8* output);
+
+        static bool isFormatSupported(const SDL_AudioFormat format);
+
+    private:
+        SDL_AudioFormat mInputFormat;
+        SDL_AudioFormat mOutputFormat;
+        int mChannels;
+        int mInputFrequency;
+        int mOutputFrequency;
+
+        Resampler mResampler;
+        Limiter mLimiter;
+
+        std::atomic<float> mVolume;
+        std::atomic<float> mTrackGain;
+        float mAppliedGain;
+
+        std::vector<float> mInputBuffer;
+        std::vector<float> mOutputBuffer;
+
+        AudioPipeline(const AudioPipeline& copy);
+
+};
@@ -0,0 +1,125 @@
+#include "limiter.h"
+
+#include "samplekernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// -0.3 dBFS, leave some room for the integer conversion
+const float Limiter::THRESHOLD = 0.966f;
+const int Limiter::LOOK_AHEAD_MS = 5;
+const int Limiter::RELEASE_MS = 80;
+
+Limiter::Limiter() :
+    mChannels(0),
+    mLookAhead(0),
+    mReleaseCoefficient(0.0f),
+    mReductionFirst(0),
+    mReductionCount(0),
+    mFrame(0),
+    mReleaseGain(1.0f),
+    mAveragePosition(0),
+    mAverageSum(0.0),
+    mReducedFrames(0) {
+}
+
+Limiter::~Limiter() {
+}
+
+void Limiter::setup(const int frequency, const int channels) {
+    mChannels = channels;
+    mLookAhead = std::max(1, frequency * LOOK_AHEAD_MS / 1000);
+    mReleaseCoefficient = 1.0f - std::exp(-1.0f / (frequency * RELEASE_MS / 1000.0f));
+    mDelay.resize(mLookAhead * mChannels);
+    mReductions.resize(mLookAhead + 1);
+    mAverageWindow.resize(mLookAhead);
+    reset();
+}
+
+void Limiter::reset() {
+    std::fill(mDelay.begin(), mDelay.end(), 0.0f);
+    std::fill(mAverageWindow.begin(), mAverageWindow.end(), 1.0f);
+    mReductionFirst = 0;
+    mReductionCount = 0;
+    mFrame = 0;
+    mReleaseGain = 1.0f;
+    mAveragePosition = 0;
+    mAverageSum = (double) mLookAhead;
+    mReducedFrames = 0;
+}
+
+size_t Limiter::getLatency() const {
+    return mLookAhead;
+}
+
+bool Limiter::isIdle() const {
+    return mReductionCount == 0 && mReleaseGain == 1.0f && mReducedFrames == 0;
+}
+
+void Limiter::process(float* samples, const size_t frames) {
+    if (frames == 0 || mChannels == 0) {
+        return;
+    }
+
+    // Delayed signal: previous look-ahead frames followed by the new ones
+    const auto delaySamples = mLookAhead * mChannels;
+    const auto samplesCount = frames * mChannels;
+    mScratch.resize(delaySamples + samplesCount);
+    memcpy(mScratch.data(), mDelay.data(), delaySamples * sizeof(float));
+    memcpy(mScratch.data() + delaySamples, samples, samplesCount * sizeof(float));
+
+    if (isIdle() && SampleKernels::getPeak(samples, samplesCount) <= THRESHOLD) {
+        // Nothing to limit, only delay
+        memcpy(samples, mScratch.data(), samplesCount * sizeof(float));
+        memcpy(mDelay.data(), mScratch.data() + samplesCount, delaySamples * sizeof(float));
+        mFrame += frames;
+        return;
+    }
+
+    mGains.resize(frames);
+    const auto capacity = mReductions.size();
+    for (size_t i=0; i<frames; i++, mFrame++) {
+        const auto* frame = samples + i * mChannels;
+        auto peak = 0.0f;
+        for (auto channel=0; channel<mChannels; channel++) {
+            peak = std::max(peak, std::abs(frame[channel]));
+        }
+
+        // Keep the queue increasing so its first entry is the window minimum
+        while (mReductionCount > 0 && mReductions[mReductionFirst].frame + mLookAhead < mFrame) {
+            mReductionFirst = (mReductionFirst + 1) % capacity;
+            mReductionCount--;
+        }
+        if (peak > THRESHOLD) {
+            const auto required = THRESHOLD / peak;
+            while (mReductionCount > 0
+                && mReductions[(mReductionFirst + mReductionCount - 1) % capacity].gain >= required) {
+                mReductionCount--;
+            }
+            mReductions[(mReductionFirst + mReductionCount) % capacity] = { mFrame, required };
+            mReductionCount++;
+        }
+        const auto minimum = mReductionCount > 0 ? mReductions[mReductionFirst].gain : 1.0f;
+
+        // Instant attack, exponential release
+        mReleaseGain = std::min(minimum, mReleaseGain + (1.0f - mReleaseGain) * mReleaseCoefficient);
+        if (mReleaseGain > 0.9999f) {
+            mReleaseGain = 1.0f;
+        }
+
+        // Averaging over the look-ahead turns the attack into a ramp which
+        // still reach the required gain when the delayed peak comes out.
+        const auto previous = mAverageWindow[mAveragePosition];
+        mReducedFrames += (mReleaseGain < 1.0f) - (previous < 1.0f);
+        mAverageSum += mReleaseGain - previous;
+        mAverageWindow[mAveragePosition] = mReleaseGain;
+        mAveragePosition = (mAveragePosition + 1) % mLookAhead;
+
+        mGains[i] = mReducedFrames > 0 ? (float) (mAverageSum / mLookAhead) : 1.0f;
+    }
+
+    memcpy(samples, mScratch.data(), samplesCount * sizeof(float));
+    memcpy(mDelay.data(), mScratch.data() + samplesCount, delaySamples * sizeof(float));
+    SampleKernels::applyFrameGains(samples, mGains.data(), frames, mChannels);
+}
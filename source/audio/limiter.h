@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <SDL2/SDL_stdinc.h>
+
+// Look-ahead peak limiter for interleaved float samples.
+// The output is delayed by the look-ahead so the gain is already down
+// when a peak comes out, it never goes over the threshold.
+class Limiter {
+
+    public:
+        Limiter();
+        virtual ~Limiter();
+
+        void setup(const int frequency, const int channels);
+        void reset();
+
+        size_t getLatency() const;
+        void process(float* samples, const size_t frames);
+
+    private:
+        static const float THRESHOLD;
+        static const int LOOK_AHEAD_MS;
+        static const int RELEASE_MS;
+
+        struct Reduction {
+            Uint64 frame;
+            float gain;
+        };
+
+        int mChannels;
+        size_t mLookAhead;
+        float mReleaseCoefficient;
+
+        // Last mLookAhead input frames, oldest first
+        std::vector<float> mDelay;
+        std::vector<float> mScratch;
+        std::vector<float> mGains;
+
+        // Minimum of the required gains over the look-ahead window, only
+        // frames needing a reduction are queued (monotonic queue in a ring).
+        std::vector<Reduction> mReductions;
+        size_t mReductionFirst;
+        size_t mReductionCount;
+        Uint64 mFrame;
+
+        // Released gains averaged over the look-ahead window
+        float mReleaseGain;
+        std::vector<float> mAverageWindow;
+        size_t mAveragePosition;
+        double mAverageSum;
+        size_t mReducedFrames;
+
+        Limiter(const Limiter& copy);
+
+        bool isIdle() const;
+
+};
@@ -0,0 +1,165 @@
+#include "loudnessmeter.h"
+
+#include "samplekernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+const float LoudnessMeter::SILENCE = -70.0f;
+
+namespace {
+    const int SEGMENTS_PER_BLOCK = 4;
+    const double RELATIVE_GATE = -10.0;
+    const int OVERSAMPLING = 4;
+}
+
+LoudnessMeter::LoudnessMeter() :
+    mChannels(0),
+    mShelvingFilter({ 1.0, 0.0, 0.0, 0.0, 0.0 }),
+    mHighPassFilter({ 1.0, 0.0, 0.0, 0.0, 0.0 }),
+    mSegmentLength(0),
+    mSegmentPosition(0),
+    mSegmentSum(0.0),
+    mPeak(0.0f) {
+}
+
+LoudnessMeter::~LoudnessMeter() {
+}
+
+bool LoudnessMeter::setup(const int frequency, const int channels) {
+    if (frequency <= 0 || channels <= 0) {
+        return false;
+    }
+
+    // K-weighting filters from BS.1770, computed for any sample rate
+    // (same derivation as libebur128).
+    auto f0 = 1681.974450955533;
+    const auto gain = 3.999843853973347;
+    auto q = 0.7071752369554196;
+    auto k = std::tan(M_PI * f0 / frequency);
+    const auto vh = std::pow(10.0, gain / 20.0);
+    const auto vb = std::pow(vh, 0.4996667741545416);
+    auto a0 = 1.0 + k / q + k * k;
+    mShelvingFilter = {
+        (vh + vb * k / q + k * k) / a0,
+        2.0 * (k * k - vh) / a0,
+        (vh - vb * k / q + k * k) / a0,
+        2.0 * (k * k - 1.0) / a0,
+        (1.0 - k / q + k * k) / a0
+    };
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / frequency);
+    a0 = 1.0 + k / q + k * k;
+    mHighPassFilter = {
+        1.0,
+        -2.0,
+        1.0,
+        2.0 * (k * k - 1.0) / a0,
+        (1.0 - k / q + k * k) / a0
+    };
+
+    mChannels = channels;
+    mSegmentLength = frequency / 10;
+    if (!mOversampler.setup(frequency, frequency * OVERSAMPLING, channels)) {
+        return false;
+    }
+
+    reset();
+    return true;
+}
+
+void LoudnessMeter::reset() {
+    mFilterStates.assign(mChannels * 4, 0.0);
+    mSegmentPosition = 0;
+    mSegmentSum = 0.0;
+    mSegments.clear();
+    mOversampler.reset();
+    mPeak = 0.0f;
+}
+
+void LoudnessMeter::process(const float* samples, const size_t frames) {
+    if (mChannels == 0) {
+        return;
+    }
+
+    for (size_t frame=0; frame<frames; frame++) {
+        for (auto channel=0; channel<mChannels; channel++) {
+            auto* state = &mFilterStates[channel * 4];
+
+            // Transposed direct form II, shelving then high pass
+            const double x = samples[frame * mChannels + channel];
+            const auto y = mShelvingFilter.b0 * x + state[0];
+            state[0] = mShelvingFilter.b1 * x - mShelvingFilter.a1 * y + state[1];
+            state[1] = mShelvingFilter.b2 * x - mShelvingFilter.a2 * y;
+
+            const auto z = mHighPassFilter.b0 * y + state[2];
+            state[2] = mHighPassFilter.b1 * y - mHighPassFilter.a1 * z + state[3];
+            state[3] = mHighPassFilter.b2 * y - mHighPassFilter.a2 * z;
+
+            mSegmentSum += z * z;
+        }
+
+        if (++mSegmentPosition == mSegmentLength) {
+            mSegments.push_back(mSegmentSum / mSegmentLength);
+            mSegmentPosition = 0;
+            mSegmentSum = 0.0;
+        }
+    }
+
+    mOversampled.resize(mOversampler.getMaxOutputFrames(frames) * mChannels);
+    const auto oversampledFrames = mOversampler.process(samples, frames, mOversampled.data());
+    mPeak = std::max(mPeak, SampleKernels::getPeak(mOversampled.data(), oversampledFrames * mChannels));
+}
+
+double LoudnessMeter::toLoudness(const double energy) {
+    return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : SILENCE;
+}
+
+float LoudnessMeter::getIntegratedLoudness() const {
+    if (mSegments.size() < SEGMENTS_PER_BLOCK) {
+        return SILENCE;
+    }
+
+    std::vector<double> blocks;
+    blocks.reserve(mSegments.size());
+    for (size_t i=0; i+SEGMENTS_PER_BLOCK<=mSegments.size(); i++) {
+        auto energy = 0.0;
+        for (auto j=0; j<SEGMENTS_PER_BLOCK; j++) {
+            energy += mSegments[i + j];
+        }
+        blocks.push_back(energy / SEGMENTS_PER_BLOCK);
+    }
+
+    // Absolute gate then relative gate
+    auto sum = 0.0;
+    size_t count = 0;
+    for (const auto energy : blocks) {
+        if (toLoudness(energy) > SILENCE) {
+            sum += energy;
+            count++;
+        }
+    }
+    if (count == 0) {
+        return SILENCE;
+    }
+
+    const auto relativeGate = toLoudness(sum / count) + RELATIVE_GATE;
+    sum = 0.0;
+    count = 0;
+    for (const auto energy : blocks) {
+        if (const auto loudness = toLoudness(energy);
+            loudness > SILENCE && loudness > relativeGate) {
+
+            sum += energy;
+            count++;
+        }
+    }
+
+    return count > 0 ? (float) toLoudness(sum / count) : SILENCE;
+}
+
+float LoudnessMeter::getTruePeak() const {
+    return mPeak > 0.0f ? 20.0f * std::log10(mPeak) : SILENCE;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "resampler.h"
+
+#include <vector>
+#include <SDL2/SDL_stdinc.h>
+
+// EBU R128 / ITU-R BS.1770 integrated loudness and true peak of a stream
+// of interleaved float samples (all channels weighted 1, as for stereo).
+class LoudnessMeter {
+
+    public:
+        // Loudness reported for silence, the absolute gate
+        static const float SILENCE;
+
+        LoudnessMeter();
+        virtual ~LoudnessMeter();
+
+        bool setup(const int frequency, const int channels);
+        void reset();
+        void process(const float* samples, const size_t frames);
+
+        // LUFS
+        float getIntegratedLoudness() const;
+        // dBTP
+        float getTruePeak() const;
+
+    private:
+        struct Biquad {
+            double b0, b1, b2, a1, a2;
+        };
+
+        int mChannels;
+        Biquad mShelvingFilter;
+        Biquad mHighPassFilter;
+        // Two filters states (z1, z2) per channel
+        std::vector<double> mFilterStates;
+
+        // Mean square of 100 ms segments, gating blocks are 4 segments (400 ms, 75% overlap)
+        size_t mSegmentLength;
+        size_t mSegmentPosition;
+        double mSegmentSum;
+        std::vector<double> mSegments;
+
+        // True peak on the signal oversampled 4 times
+        Resampler mOversampler;
+        std::vector<float> mOversampled;
+        float mPeak;
+
+        LoudnessMeter(const LoudnessMeter& copy);
+
+        static double toLoudness(const double energy);
+};
@@ -0,0 +1,197 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // Kaiser window shape, ~80 dB stop band
+    const double KAISER_BETA = 8.0;
+    // Pass band edge relative to the lowest Nyquist frequency
+    const double CUTOFF = 0.95;
+
+    double besselI0(const double x) {
+        auto sum = 1.0;
+        auto term = 1.0;
+        for (auto k=1; k<32; k++) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+}
+
+Resampler::Resampler() :
+    mInputFrequency(0),
+    mOutputFrequency(0),
+    mChannels(0),
+    mUpFactor(1),
+    mDownFactor(1),
+    mPhaseCount(1),
+    mInputIndex(0),
+    mPhase(0) {
+}
+
+Resampler::~Resampler() {
+}
+
+bool Resampler::setup(const int inputFrequency, const int outputFrequency, const int channels) {
+    if (inputFrequency <= 0 || outputFrequency <= 0 || channels <= 0) {
+        return false;
+    }
+
+    // Keep the history when nothing change, a gapless switch between songs
+    // rendered at the same rate must not click.
+    if (inputFrequency == mInputFrequency && outputFrequency == mOutputFrequency && channels == mChannels) {
+        return true;
+    }
+
+    mInputFrequency = inputFrequency;
+    mOutputFrequency = outputFrequency;
+    mChannels = channels;
+
+    const auto divisor = std::gcd(inputFrequency, outputFrequency);
+    mUpFactor = outputFrequency / divisor;
+    mDownFactor = inputFrequency / divisor;
+    mPhaseCount = std::min(mUpFactor, MAX_PHASES);
+
+    if (!isBypassed()) {
+        buildCoefficients();
+    }
+
+    mHistory.assign(mChannels, std::vector<float>());
+    reset();
+    return true;
+}
+
+void Resampler::reset() {
+    // Start centered on the first input sample
+    for (auto& history : mHistory) {
+        history.assign(TAPS / 2 - 1, 0.0f);
+    }
+    mInputIndex = 0;
+    mPhase = 0;
+}
+
+bool Resampler::isBypassed() const {
+    return mInputFrequency == mOutputFrequency;
+}
+
+// Input frames needed to produce about outputFrames frames
+size_t Resampler::getInputFrames(const size_t outputFrames) const {
+    if (isBypassed()) {
+        return outputFrames;
+    }
+
+    return std::max((size_t) 1, (outputFrames * mDownFactor) / mUpFactor);
+}
+
+size_t Resampler::getMaxOutputFrames(const size_t inputFrames) const {
+    if (isBypassed()) {
+        return inputFrames;
+    }
+
+    return ((inputFrames + TAPS) * mUpFactor) / mDownFactor + 1;
+}
+
+void Resampler::buildCoefficients() {
+    // Low pass at the lowest of both Nyquist frequencies, in input sample unit
+    const auto cutoff = 0.5 * CUTOFF * std::min(1.0, (double) mUpFactor / mDownFactor);
+    const auto halfLength = TAPS / 2.0;
+    const auto windowNorm = besselI0(KAISER_BETA);
+
+    mCoefficients.resize(mPhaseCount * TAPS);
+    for (auto phase=0; phase<mPhaseCount; phase++) {
+        const auto fraction = (double) phase / mPhaseCount;
+        auto* coefficients = &mCoefficients[phase * TAPS];
+        auto sum = 0.0;
+
+        for (auto tap=0; tap<TAPS; tap++) {
+            // Distance between the tap and the output position
+            const auto t = tap - (TAPS / 2 - 1) - fraction;
+            const auto x = 2.0 * cutoff * t;
+            const auto sinc = std::abs(x) < 1e-9 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            const auto ratio = t / halfLength;
+            const auto window = std::abs(ratio) < 1.0
+                ? besselI0(KAISER_BETA * std::sqrt(1.0 - ratio * ratio)) / windowNorm
+                : 0.0;
+
+            coefficients[tap] = (float) (2.0 * cutoff * sinc * window);
+            sum += coefficients[tap];
+        }
+
+        // Unity gain for every phase
+        for (auto tap=0; tap<TAPS; tap++) {
+            coefficients[tap] = (float) (coefficients[tap] / sum);
+        }
+    }
+}
+
+float Resampler::dotProduct(const float* coefficients, const float* samples) {
+#if defined(__SSE2__)
+    auto sum = _mm_setzero_ps();
+    for (auto i=0; i<TAPS; i+=4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(coefficients + i), _mm_loadu_ps(samples + i)));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON)
+    auto sum = vdupq_n_f32(0.0f);
+    for (auto i=0; i<TAPS; i+=4) {
+        sum = vmlaq_f32(sum, vld1q_f32(coefficients + i), vld1q_f32(samples + i));
+    }
+    const auto pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#else
+    auto sum = 0.0f;
+    for (auto i=0; i<TAPS; i++) {
+        sum += coefficients[i] * samples[i];
+    }
+    return sum;
+#endif
+}
+
+size_t Resampler::process(const float* input, const size_t inputFrames, float* output) {
+    if (isBypassed()) {
+        std::copy(input, input + inputFrames * mChannels, output);
+        return inputFrames;
+    }
+
+    for (auto channel=0; channel<mChannels; channel++) {
+        auto& history = mHistory[channel];
+        const auto start = history.size();
+        history.resize(start + inputFrames);
+        for (size_t frame=0; frame<inputFrames; frame++) {
+            history[start + frame] = input[frame * mChannels + channel];
+        }
+    }
+
+    const auto available = mHistory[0].size();
+    size_t outputFrames = 0;
+    while (mInputIndex + TAPS <= available) {
+        const auto* coefficients = &mCoefficients[(size_t) mPhase * mPhaseCount / mUpFactor * TAPS];
+        for (auto channel=0; channel<mChannels; channel++) {
+            output[outputFrames * mChannels + channel] = dotProduct(coefficients, &mHistory[channel][mInputIndex]);
+        }
+        outputFrames++;
+
+        mPhase += mDownFactor;
+        mInputIndex += mPhase / mUpFactor;
+        mPhase %= mUpFactor;
+    }
+
+    // Only keep what the next outputs still need
+    for (auto& history : mHistory) {
+        history.erase(history.begin(), history.begin() + std::min(mInputIndex, history.size()));
+    }
+    mInputIndex -= std::min(mInputIndex, available);
+
+    return outputFrames;
+}
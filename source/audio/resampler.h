@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <SDL2/SDL_stdinc.h>
+
+// Polyphase windowed sinc resampler for interleaved float samples.
+// Keeps its history between calls so a stream can be converted chunk by chunk.
+class Resampler {
+
+    public:
+        Resampler();
+        virtual ~Resampler();
+
+        bool setup(const int inputFrequency, const int outputFrequency, const int channels);
+        void reset();
+
+        bool isBypassed() const;
+        size_t getInputFrames(const size_t outputFrames) const;
+        size_t getMaxOutputFrames(const size_t inputFrames) const;
+
+        // Consume all input frames and return the amount of frames written to output,
+        // output must be able to hold getMaxOutputFrames(inputFrames) frames.
+        size_t process(const float* input, const size_t inputFrames, float* output);
+
+    private:
+        // Taps per phase, multiple of 4 for the SIMD kernels
+        static const int TAPS = 32;
+        // Phases are quantized above this, for ratios like 48000/44056
+        static const int MAX_PHASES = 512;
+
+        int mInputFrequency;
+        int mOutputFrequency;
+        int mChannels;
+
+        // Output frame n is at input position n * mDownFactor / mUpFactor
+        int mUpFactor;
+        int mDownFactor;
+        int mPhaseCount;
+        std::vector<float> mCoefficients;
+
+        // Planar history, one vector per channel
+        std::vector<std::vector<float>> mHistory;
+        size_t mInputIndex;
+        int mPhase;
+
+        Resampler(const Resampler& copy);
+
+        void buildCoefficients();
+
+        static float dotProduct(const float* coefficients, const float* samples);
+
+};
@@ -0,0 +1,100 @@
+#include "ringbuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+RingBuffer::RingBuffer() :
+    mReadPosition(0),
+    mWritePosition(0),
+    mDiscardPosition(0),
+    mDiscardRequested(false) {
+}
+
+RingBuffer::~RingBuffer() {
+}
+
+void RingBuffer::resize(const size_t capacity) {
+    mBuffer.assign(capacity, 0);
+    clear();
+}
+
+void RingBuffer::clear() {
+    mReadPosition.store(0, std::memory_order_relaxed);
+    mWritePosition.store(0, std::memory_order_relaxed);
+    mDiscardPosition.store(0, std::memory_order_relaxed);
+    mDiscardRequested.store(false, std::memory_order_relaxed);
+}
+
+size_t RingBuffer::getCapacity() const {
+    return mBuffer.size();
+}
+
+size_t RingBuffer::getAvailableRead() const {
+    // Positions are free running counters, only their difference matters
+    auto readPosition = mReadPosition.load(std::memory_order_acquire);
+    const auto isDiscardRequested = mDiscardRequested.load(std::memory_order_acquire);
+    const auto writePosition = mWritePosition.load(std::memory_order_acquire);
+    if (isDiscardRequested) {
+        readPosition = getDiscardedPosition(readPosition, writePosition);
+    }
+
+    return writePosition - readPosition;
+}
+
+size_t RingBuffer::getAvailableWrite() const {
+    // Discarded data is still there until the reader skips it
+    return mBuffer.size() - (mWritePosition.load(std::memory_order_acquire) - mReadPosition.load(std::memory_order_acquire));
+}
+
+size_t RingBuffer::write(const Uint8* data, const size_t len) {
+    const auto capacity = mBuffer.size();
+    const auto writePosition = mWritePosition.load(std::memory_order_relaxed);
+    const auto readPosition = mReadPosition.load(std::memory_order_acquire);
+    const auto toWrite = std::min(len, capacity - (writePosition - readPosition));
+    if (toWrite == 0) {
+        return 0;
+    }
+
+    // Copy in two parts when wrapping around the end of the buffer
+    const auto offset = writePosition % capacity;
+    const auto firstPart = std::min(toWrite, capacity - offset);
+    memcpy(mBuffer.data() + offset, data, firstPart);
+    memcpy(mBuffer.data(), data + firstPart, toWrite - firstPart);
+
+    mWritePosition.store(writePosition + toWrite, std::memory_order_release);
+    return toWrite;
+}
+
+size_t RingBuffer::read(Uint8* data, const size_t len) {
+    const auto capacity = mBuffer.size();
+    auto readPosition = mReadPosition.load(std::memory_order_relaxed);
+    const auto isDiscardRequested = mDiscardRequested.exchange(false, std::memory_order_acquire);
+    const auto writePosition = mWritePosition.load(std::memory_order_acquire);
+    if (isDiscardRequested) {
+        readPosition = getDiscardedPosition(readPosition, writePosition);
+        mReadPosition.store(readPosition, std::memory_order_release);
+    }
+    const auto toRead = std::min(len, writePosition - readPosition);
+    if (toRead == 0) {
+        return 0;
+    }
+
+    const auto offset = readPosition % capacity;
+    const auto firstPart = std::min(toRead, capacity - offset);
+    memcpy(data, mBuffer.data() + offset, firstPart);
+    memcpy(data + firstPart, mBuffer.data(), toRead - firstPart);
+
+    mReadPosition.store(readPosition + toRead, std::memory_order_release);
+    return toRead;
+}
+
+void RingBuffer::discard() {
+    mDiscardPosition.store(mWritePosition.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mDiscardRequested.store(true, std::memory_order_release);
+}
+
+size_t RingBuffer::getDiscardedPosition(const size_t readPosition, const size_t writePosition) const {
+    // The discard position is never past what was written, unless a clear() happened
+    const auto discardPosition = mDiscardPosition.load(std::memory_order_relaxed);
+    return discardPosition - readPosition <= writePosition - readPosition ? discardPosition : readPosition;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <SDL2/SDL_stdinc.h>
+
+// Single producer / single consumer byte ring buffer.
+// write() and discard() must only be called from one thread and read() from
+// another one, resize() and clear() need both sides to be stopped.
+class RingBuffer {
+
+    public:
+        RingBuffer();
+        virtual ~RingBuffer();
+
+        void resize(const size_t capacity);
+        void clear();
+
+        size_t getCapacity() const;
+        size_t getAvailableRead() const;
+        size_t getAvailableWrite() const;
+
+        size_t write(const Uint8* data, const size_t len);
+        size_t read(Uint8* data, const size_t len);
+
+        // Producer side, what was written so far is dropped by the next read().
+        // It is not readable anymore but keeps its room until then.
+        void discard();
+
+    private:
+        std::vector<Uint8> mBuffer;
+        std::atomic<size_t> mReadPosition;
+        std::atomic<size_t> mWritePosition;
+        std::atomic<size_t> mDiscardPosition;
+        std::atomic<bool> mDiscardRequested;
+
+        size_t getDiscardedPosition(const size_t readPosition, const size_t writePosition) const;
+
+        RingBuffer(const RingBuffer& copy);
+
+};
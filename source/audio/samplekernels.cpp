@@ -0,0 +1,175 @@
+#include "samplekernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void SampleKernels::convertS16ToFloat(const Sint16* input, float* output, const size_t count) {
+    const auto scale = 1.0f / 32768.0f;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const auto vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        const auto samples = _mm_loadu_si128((const __m128i*) (input + i));
+        // Sign extend by moving each 16 bits value in the high half then shifting back
+        const auto low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const auto high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), vscale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), vscale));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        const auto samples = vld1q_s16(input + i);
+        vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), scale));
+        vst1q_f32(output + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), scale));
+    }
+#endif
+
+    for (; i < count; i++) {
+        output[i] = input[i] * scale;
+    }
+}
+
+void SampleKernels::convertFloatToS16(const float* input, Sint16* output, const size_t count) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Conversion round to nearest and packing saturate
+    const auto vscale = _mm_set1_ps(32768.0f);
+    for (; i + 8 <= count; i += 8) {
+        const auto low = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(input + i), vscale));
+        const auto high = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(input + i + 4), vscale));
+        _mm_storeu_si128((__m128i*) (output + i), _mm_packs_epi32(low, high));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 8 <= count; i += 8) {
+        const auto low = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(input + i), 32768.0f));
+        const auto high = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(input + i + 4), 32768.0f));
+        vst1q_s16(output + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        output[i] = (Sint16) std::clamp(std::lrint(input[i] * 32768.0f), -32768l, 32767l);
+    }
+}
+
+void SampleKernels::applyGain(float* samples, const size_t count, const float gain) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const auto vgain = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), vgain));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(samples + i, vmulq_n_f32(vld1q_f32(samples + i), gain));
+    }
+#endif
+
+    for (; i < count; i++) {
+        samples[i] *= gain;
+    }
+}
+
+// Linear transition between two gains, avoid clicks on volume changes
+void SampleKernels::applyGainRamp(float* samples, const size_t frames, const int channels,
+    const float startGain, const float endGain) {
+
+    if (frames == 0) {
+        return;
+    }
+
+    const auto step = (endGain - startGain) / frames;
+    for (size_t frame=0; frame<frames; frame++) {
+        const auto gain = startGain + step * (frame + 1);
+        for (auto channel=0; channel<channels; channel++) {
+            samples[frame * channels + channel] *= gain;
+        }
+    }
+}
+
+void SampleKernels::applyFrameGains(float* samples, const float* gains, const size_t frames, const int channels) {
+    size_t frame = 0;
+
+#if defined(__SSE2__)
+    if (channels == 2) {
+        for (; frame + 4 <= frames; frame += 4) {
+            const auto frameGains = _mm_loadu_ps(gains + frame);
+            auto* stereo = samples + frame * 2;
+            _mm_storeu_ps(stereo, _mm_mul_ps(_mm_loadu_ps(stereo), _mm_unpacklo_ps(frameGains, frameGains)));
+            _mm_storeu_ps(stereo + 4, _mm_mul_ps(_mm_loadu_ps(stereo + 4), _mm_unpackhi_ps(frameGains, frameGains)));
+        }
+    }
+#elif defined(__ARM_NEON)
+    if (channels == 2) {
+        for (; frame + 4 <= frames; frame += 4) {
+            auto stereo = vld2q_f32(samples + frame * 2);
+            const auto frameGains = vld1q_f32(gains + frame);
+            stereo.val[0] = vmulq_f32(stereo.val[0], frameGains);
+            stereo.val[1] = vmulq_f32(stereo.val[1], frameGains);
+            vst2q_f32(samples + frame * 2, stereo);
+        }
+    }
+#endif
+
+    for (; frame < frames; frame++) {
+        for (auto channel=0; channel<channels; channel++) {
+            samples[frame * channels + channel] *= gains[frame];
+        }
+    }
+}
+
+// Add input to samples
+void SampleKernels::mix(float* samples, const float* input, const size_t count) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_add_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(input + i)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(samples + i, vaddq_f32(vld1q_f32(samples + i), vld1q_f32(input + i)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        samples[i] += input[i];
+    }
+}
+
+float SampleKernels::getPeak(const float* samples, const size_t count) {
+    auto peak = 0.0f;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const auto absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    auto vpeak = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        vpeak = _mm_max_ps(vpeak, _mm_and_ps(_mm_loadu_ps(samples + i), absMask));
+    }
+    vpeak = _mm_max_ps(vpeak, _mm_movehl_ps(vpeak, vpeak));
+    vpeak = _mm_max_ss(vpeak, _mm_shuffle_ps(vpeak, vpeak, 1));
+    peak = _mm_cvtss_f32(vpeak);
+#elif defined(__ARM_NEON)
+    auto vpeak = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        vpeak = vmaxq_f32(vpeak, vabsq_f32(vld1q_f32(samples + i)));
+    }
+    const auto pair = vpmax_f32(vget_low_f32(vpeak), vget_high_f32(vpeak));
+    peak = vget_lane_f32(vpmax_f32(pair, pair), 0);
+#endif
+
+    for (; i < count; i++) {
+        peak = std::max(peak, std::abs(samples[i]));
+    }
+    return peak;
+}
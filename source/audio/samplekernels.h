@@ -0,0 +1,24 @@
+#pragma once
+
+#include <SDL2/SDL_stdinc.h>
+
+// Vectorised loops used by the audio pipeline, with SSE2 / NEON versions
+// when available and a scalar fallback.
+class SampleKernels {
+
+    public:
+        static void convertS16ToFloat(const Sint16* input, float* output, const size_t count);
+        static void convertFloatToS16(const float* input, Sint16* output, const size_t count);
+
+        static void applyGain(float* samples, const size_t count, const float gain);
+        static void applyGainRamp(float* samples, const size_t frames, const int channels,
+            const float startGain, const float endGain);
+        static void applyFrameGains(float* samples, const float* gains, const size_t frames, const int channels);
+        static void mix(float* samples, const float* input, const size_t count);
+
+        static float getPeak(const float* samples, const size_t count);
+
+    private:
+        SampleKernels();
+
+};
@@ -0,0 +1,103 @@
+#include "wavwriter.h"
+
+#include <cstring>
+#include <SDL2/SDL_endian.h>
+
+// Values are always stored little endian
+static void putLE16(Uint8* data, const uint16_t value) {
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+}
+
+static void putLE32(Uint8* data, const uint32_t value) {
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = (value >> 24) & 0xFF;
+}
+
+WavWriter::WavWriter() :
+    mFrequency(0),
+    mChannels(0),
+    mDataLength(0) {
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+std::string WavWriter::getError() const {
+    return mError;
+}
+
+bool WavWriter::open(const std::filesystem::path path, const int frequency, const int channels) {
+    mStream.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!mStream.good()) {
+        mError = std::string("Cannot create ").append(path.string());
+        return false;
+    }
+
+    mFrequency = frequency;
+    mChannels = channels;
+    mDataLength = 0;
+
+    // Header is written again with the final sizes on close
+    writeHeader();
+    return mStream.good();
+}
+
+bool WavWriter::write(const Uint8* data, const size_t len) {
+    if (!mStream.is_open()) {
+        return false;
+    }
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    for (size_t i=0; i<len; i+=2) {
+        const char sample[2] = { (char) data[i+1], (char) data[i] };
+        mStream.write(sample, 2);
+    }
+#else
+    mStream.write((const char*) data, len);
+#endif
+
+    mDataLength += len;
+    if (!mStream.good()) {
+        mError = "Write error.";
+        return false;
+    }
+
+    return true;
+}
+
+bool WavWriter::close() {
+    if (!mStream.is_open()) {
+        return true;
+    }
+
+    mStream.seekp(0, std::ios::beg);
+    writeHeader();
+    mStream.close();
+
+    return !mStream.fail();
+}
+
+void WavWriter::writeHeader() {
+    const auto blockAlign = mChannels * 2;
+
+    Uint8 header[44];
+    memcpy(header, "RIFF", 4);
+    putLE32(header + 4, 36 + mDataLength);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + 12, "fmt ", 4);
+    putLE32(header + 16, 16);
+    putLE16(header + 20, 1);
+    putLE16(header + 22, mChannels);
+    putLE32(header + 24, mFrequency);
+    putLE32(header + 28, mFrequency * blockAlign);
+    putLE16(header + 32, blockAlign);
+    putLE16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    putLE32(header + 40, mDataLength);
+
+    mStream.write((const char*) header, sizeof(header));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <SDL2/SDL_stdinc.h>
+
+// Minimal RIFF/WAVE writer for 16 bits PCM
+class WavWriter {
+
+    public:
+        WavWriter();
+        virtual ~WavWriter();
+
+        bool open(const std::filesystem::path path, const int frequency, const int channels);
+        bool write(const Uint8* data, const size_t len);
+        bool close();
+
+        std::string getError() const;
+
+    private:
+        std::ofstream mStream;
+        std::string mError;
+        int mFrequency;
+        int mChannels;
+        uint32_t mDataLength;
+
+        WavWriter(const WavWriter& copy);
+
+        void writeHeader();
+
+};
@@ -1,6 +1,12 @@
 #include "decoder.h"
 
-Decoder::Decoder() {
+#include <algorithm>
+#include <cstring>
+
+const int Decoder::DEFAULT_AUDIO_FREQUENCY = 48000;
+
+Decoder::Decoder() :
+    mRenderedLength(0) {
 }
 
 Decoder::~Decoder() {
@@ -10,6 +16,30 @@ std::string Decoder::getError() const {
     return mError;
 }
 
+// Amount of bytes really rendered by the last process call,
+// it can be less than requested when the song finished.
+int Decoder::getRenderedLength() const {
+    return mRenderedLength;
+}
+
+int Decoder::getTrackNumber() const {
+    return mMetaData.trackInformation.trackNumber;
+}
+
+bool Decoder::canRead(const std::string extention) const {
+    const auto extensions = getExtensions();
+    return std::find(extensions.begin(), extensions.end(), extention) != extensions.end();
+}
+
+int Decoder::sniff(const FileView content) const {
+    return 0;
+}
+
+bool Decoder::hasMagic(const FileView content, const size_t offset, const char* magic) {
+    const auto length = strlen(magic);
+    return content.size >= offset + length && memcmp(content.data + offset, magic, length) == 0;
+}
+
 bool Decoder::nextTrack() {
     return false;
 }
@@ -17,3 +47,8 @@ bool Decoder::nextTrack() {
 bool Decoder::prevTrack() {
     return false;
 }
+
+// Move to position (in seconds) in the current track
+bool Decoder::seek(const int position) {
+    return false;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../settings.h"
+#include "../filesystem/fileview.h"
 
 #include <string>
 #include <vector>
@@ -28,6 +29,7 @@ class Decoder {
             int trackNumber = 0;
             int duration = 0;
             int position = -1;
+            bool seekable = false;
         };
 
         struct MetaData {
@@ -36,9 +38,15 @@ class Decoder {
             TrackInformation trackInformation;
         };
 
+        // Rate used by decoders able to render at any frequency,
+        // the sound engine resample it to the device one.
+        static const int DEFAULT_AUDIO_FREQUENCY;
+
         Decoder();
         virtual ~Decoder();
 
+        // setup() is called before each play() and must be cheap once done: libraries
+        // and emulators stay ready until cleanup(), stop() only releases the song.
         virtual bool setup() = 0;
         virtual void cleanup() = 0;
 
@@ -47,20 +55,31 @@ class Decoder {
         virtual uint8_t getAudioChannels() const = 0;
         virtual SDL_AudioFormat getAudioSampleFormat() const = 0;
 
-        virtual bool canRead(const std::string extention) const = 0;
+        // Lower case, with the leading dot
+        virtual std::vector<std::string> getExtensions() const = 0;
+        // Confidence from 0 to 100 that the content is for this decoder, from its first bytes
+        virtual int sniff(const FileView content) const;
+        bool canRead(const std::string extention) const;
         virtual const MetaData getMetaData() = 0;
-        virtual bool play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) = 0;
+        virtual bool play(const FileView content, std::shared_ptr<Settings> settings) = 0;
         virtual void stop() = 0;
         virtual int process(Uint8* stream, const int len) = 0;
 
         virtual bool nextTrack();
         virtual bool prevTrack();
+        virtual bool seek(const int position);
 
         std::string getError() const;
+        int getRenderedLength() const;
+        // Cheap, without the strings of getMetaData()
+        int getTrackNumber() const;
 
     protected:
         MetaData mMetaData;
         std::string mError;
+        int mRenderedLength;
+
+        static bool hasMagic(const FileView content, const size_t offset, const char* magic);
 
     private:
         Decoder(const Decoder& copy);
@@ -0,0 +1,40 @@
+#include "decoderfactory.h"
+
+#include "dumb/dumbdecoder.h"
+#include "gme/gmedecoder.h"
+#include "sc68/sc68decoder.h"
+#include "sidplayfp/sidplaydecoder.h"
+
+DecoderFactory::DecoderFactory(const std::filesystem::path dataPath) :
+    mDataPath(dataPath) {
+}
+
+DecoderFactory::~DecoderFactory() {
+}
+
+std::vector<std::string> DecoderFactory::getNames() const {
+    return { DumbDecoder::NAME, GmeDecoder::NAME, Sc68Decoder::NAME, SidPlayDecoder::NAME };
+}
+
+std::shared_ptr<Decoder> DecoderFactory::create(const std::string name) const {
+    if (name == DumbDecoder::NAME) {
+        return std::shared_ptr<Decoder>(new DumbDecoder());
+    } else if (name == GmeDecoder::NAME) {
+        return std::shared_ptr<Decoder>(new GmeDecoder());
+    } else if (name == Sc68Decoder::NAME) {
+        return std::shared_ptr<Decoder>(new Sc68Decoder());
+    } else if (name == SidPlayDecoder::NAME) {
+        return std::shared_ptr<Decoder>(new SidPlayDecoder(std::string(mDataPath).append("/c64roms")));
+    }
+
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<Decoder>> DecoderFactory::createList() const {
+    std::vector<std::shared_ptr<Decoder>> decoderList;
+    for (const auto& name : getNames()) {
+        decoderList.push_back(create(name));
+    }
+
+    return decoderList;
+}
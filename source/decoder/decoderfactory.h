@@ -0,0 +1,31 @@
+#pragma once
+
+#include "decoder.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Create independent decoder instances. An instance must be used by one thread at
+// a time, several instances of the same decoder can run at once on different
+// threads: the libraries process wide state lives in their DecoderLibrary.
+class DecoderFactory {
+
+    public:
+        DecoderFactory(const std::filesystem::path dataPath);
+        virtual ~DecoderFactory();
+
+        // In the order decoders are tried
+        std::vector<std::string> getNames() const;
+        // nullptr for an unknown name
+        std::shared_ptr<Decoder> create(const std::string name) const;
+        // One instance of each decoder
+        std::vector<std::shared_ptr<Decoder>> createList() const;
+
+    private:
+        std::filesystem::path mDataPath;
+
+        DecoderFactory(const DecoderFactory& copy);
+
+};
@@ -0,0 +1,50 @@
+#include "decoderlibrary.h"
+
+DecoderLibrary::DecoderLibrary(const std::function<bool ()> init, const std::function<void ()> exit) :
+    mMutex(SDL_CreateMutex()),
+    mUsers(0),
+    mInit(init),
+    mExit(exit) {
+}
+
+DecoderLibrary::~DecoderLibrary() {
+    if (mMutex != nullptr) {
+        SDL_DestroyMutex(mMutex);
+        mMutex = nullptr;
+    }
+}
+
+bool DecoderLibrary::acquire() {
+    SDL_LockMutex(mMutex);
+    const auto success = mUsers > 0 || mInit == nullptr || mInit();
+    if (success) {
+        mUsers++;
+    }
+    SDL_UnlockMutex(mMutex);
+
+    return success;
+}
+
+void DecoderLibrary::release() {
+    SDL_LockMutex(mMutex);
+    if (mUsers > 0 && --mUsers == 0 && mExit != nullptr) {
+        mExit();
+    }
+    SDL_UnlockMutex(mMutex);
+}
+
+int DecoderLibrary::getUsers() const {
+    SDL_LockMutex(mMutex);
+    const auto users = mUsers;
+    SDL_UnlockMutex(mMutex);
+
+    return users;
+}
+
+void DecoderLibrary::lock() {
+    SDL_LockMutex(mMutex);
+}
+
+void DecoderLibrary::unlock() {
+    SDL_UnlockMutex(mMutex);
+}
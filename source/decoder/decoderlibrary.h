@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <SDL2/SDL_mutex.h>
+
+// Process wide state of a decoder library, shared by all its decoder instances
+// whatever thread or owner they belong to. The first acquire() initializes the
+// library, the last release() shuts it down. Writes to the library globals are
+// done with the context locked.
+class DecoderLibrary {
+
+    public:
+        DecoderLibrary(const std::function<bool ()> init, const std::function<void ()> exit);
+        virtual ~DecoderLibrary();
+
+        bool acquire();
+        void release();
+        int getUsers() const;
+
+        void lock();
+        void unlock();
+
+    private:
+        SDL_mutex* mMutex;
+        int mUsers;
+        std::function<bool ()> mInit;
+        std::function<void ()> mExit;
+
+        DecoderLibrary(const DecoderLibrary& copy);
+
+};
@@ -0,0 +1,246 @@
+#include "decoderregistry.h"
+
+#include <algorithm>
+#include <SDL2/SDL_log.h>
+
+// Added to the decoder sniff() score, the content has the last word
+const int DecoderRegistry::EXTENSION_SCORE = 50;
+// Modland names files "mod.title" instead of "title.mod"
+const int DecoderRegistry::PREFIX_SCORE = 40;
+const int DecoderRegistry::MAX_SEED_TRIES = 4096;
+// Far more than a play queue, the indexer and the analyzer forget theirs
+const size_t DecoderRegistry::MAX_WINNERS = 1024;
+
+// Packed songs are unpacked before reaching the decoders, they are found as what they hold
+static const char* PACKED_EXTENSIONS[][2] = {
+    { ".mdz", ".mod" },
+    { ".s3z", ".s3m" },
+    { ".xmz", ".xm" },
+    { ".itz", ".it" }
+};
+
+DecoderRegistry::DecoderRegistry() :
+    mSeed(0),
+    mMask(0),
+    mWinnersMutex(SDL_CreateMutex()) {
+}
+
+DecoderRegistry::~DecoderRegistry() {
+    cleanup();
+
+    if (mWinnersMutex != nullptr) {
+        SDL_DestroyMutex(mWinnersMutex);
+        mWinnersMutex = nullptr;
+    }
+}
+
+bool DecoderRegistry::setup(const std::vector<std::shared_ptr<Decoder>>& decoderList) {
+    mDecoderList = decoderList;
+
+    // First decoder declaring an extension keeps it, as the list order used to decide
+    std::vector<Slot> entries;
+    for (size_t decoder=0; decoder<decoderList.size(); decoder++) {
+        for (const auto& extension : decoderList[decoder]->getExtensions()) {
+            if (std::none_of(entries.begin(), entries.end(), [&extension](const Slot& entry) { return entry.extension == extension; })) {
+                entries.push_back({ extension, (int) decoder });
+            }
+        }
+    }
+
+    // Look for a seed without collision, in a table at least twice the number of extensions
+    size_t size = 1;
+    while (size < entries.size() * 2) {
+        size <<= 1;
+    }
+
+    for (; size <= entries.size() * 16 + 16; size <<= 1) {
+        for (Uint32 seed=0; seed<MAX_SEED_TRIES; seed++) {
+            if (buildTable(entries, size, seed)) {
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Decoder registry: %d extensions in %d slots\n",
+                    (int) entries.size(), (int) size);
+                return true;
+            }
+        }
+    }
+
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Decoder registry: cannot build extensions table\n");
+    mSlots.clear();
+    return false;
+}
+
+void DecoderRegistry::cleanup() {
+    SDL_LockMutex(mWinnersMutex);
+    mWinners.clear();
+    mWinnerIndexes.clear();
+    SDL_UnlockMutex(mWinnersMutex);
+
+    mSlots.clear();
+    mDecoderList.clear();
+}
+
+int DecoderRegistry::find(const std::filesystem::path& path) const {
+    if (const auto decoder = findExtension(getExtension(path));
+        decoder >= 0) {
+
+        return decoder;
+    }
+
+    return findExtension(getPrefixExtension(path));
+}
+
+int DecoderRegistry::find(const std::filesystem::path& path, const FileView content) {
+    // A file replaced by one of another size is ranked again
+    if (const auto decoder = findRemembered(path.string(), content.size);
+        decoder >= 0) {
+
+        return decoder;
+    }
+
+    const auto extensionDecoder = findExtension(getExtension(path));
+    const auto prefixDecoder = findExtension(getPrefixExtension(path));
+
+    // Rank every decoder, ties go to the first one
+    auto bestDecoder = -1;
+    auto bestScore = 0;
+    for (size_t decoder=0; decoder<mDecoderList.size(); decoder++) {
+        auto score = mDecoderList[decoder]->sniff(content);
+        if ((int) decoder == extensionDecoder) {
+            score += EXTENSION_SCORE;
+        }
+        if ((int) decoder == prefixDecoder) {
+            score += PREFIX_SCORE;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestDecoder = decoder;
+        }
+    }
+
+    if (bestDecoder >= 0) {
+        if (bestDecoder != extensionDecoder) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%s recognized by %s from its content\n",
+                path.c_str(), mDecoderList[bestDecoder]->getName().c_str());
+        }
+
+        remember(path.string(), content.size, bestDecoder);
+    }
+
+    return bestDecoder;
+}
+
+void DecoderRegistry::forget(const std::filesystem::path& path) {
+    SDL_LockMutex(mWinnersMutex);
+    if (const auto found = mWinnerIndexes.find(path.string());
+        found != mWinnerIndexes.end()) {
+
+        mWinners.erase(found->second);
+        mWinnerIndexes.erase(found);
+    }
+    SDL_UnlockMutex(mWinnersMutex);
+}
+
+bool DecoderRegistry::buildTable(const std::vector<Slot>& entries, const size_t size, const Uint32 seed) {
+    mSlots.assign(size, Slot());
+    mSeed = seed;
+    mMask = size - 1;
+
+    for (const auto& entry : entries) {
+        auto& slot = mSlots[hash(entry.extension, mSeed) & mMask];
+        if (slot.decoder >= 0) {
+            return false;
+        }
+        slot = entry;
+    }
+
+    return true;
+}
+
+int DecoderRegistry::findExtension(const std::string& extension) const {
+    if (extension.empty() || mSlots.empty()) {
+        return -1;
+    }
+
+    // One probe, the extension still has to be compared as unknown ones land anywhere
+    const auto& slot = mSlots[hash(extension, mSeed) & mMask];
+    return slot.extension == extension ? slot.decoder : -1;
+}
+
+int DecoderRegistry::findRemembered(const std::string& path, const size_t size) {
+    auto decoder = -1;
+
+    SDL_LockMutex(mWinnersMutex);
+    if (const auto found = mWinnerIndexes.find(path);
+        found != mWinnerIndexes.end() && found->second->size == size) {
+
+        mWinners.splice(mWinners.begin(), mWinners, found->second);
+        decoder = found->second->decoder;
+    }
+    SDL_UnlockMutex(mWinnersMutex);
+
+    return decoder;
+}
+
+void DecoderRegistry::remember(const std::string& path, const size_t size, const int decoder) {
+    SDL_LockMutex(mWinnersMutex);
+    if (const auto found = mWinnerIndexes.find(path);
+        found != mWinnerIndexes.end()) {
+
+        mWinners.erase(found->second);
+        mWinnerIndexes.erase(found);
+    }
+
+    mWinners.push_front({
+        .path = path,
+        .size = size,
+        .decoder = decoder
+    });
+    mWinnerIndexes.emplace(path, mWinners.begin());
+    if (mWinners.size() > MAX_WINNERS) {
+        mWinnerIndexes.erase(mWinners.back().path);
+        mWinners.pop_back();
+    }
+    SDL_UnlockMutex(mWinnersMutex);
+}
+
+Uint32 DecoderRegistry::hash(const std::string& key, const Uint32 seed) {
+    // FNV-1a, the seed is mixed in the offset basis
+    Uint32 value = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (const auto c : key) {
+        value ^= (Uint8) c;
+        value *= 16777619u;
+    }
+
+    return value ^ (value >> 16);
+}
+
+std::string DecoderRegistry::getExtension(const std::filesystem::path& path) {
+    auto extension = std::string(path.extension());
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    // "title.mod.gz" is a mod
+    if (extension == ".gz") {
+        return getExtension(path.stem());
+    }
+
+    for (const auto& packed : PACKED_EXTENSIONS) {
+        if (extension == packed[0]) {
+            return packed[1];
+        }
+    }
+
+    return extension;
+}
+
+std::string DecoderRegistry::getPrefixExtension(const std::filesystem::path& path) {
+    const auto filename = std::string(path.filename());
+    const auto dot = filename.find('.');
+    if (dot == std::string::npos || dot == 0 || dot + 1 == filename.size()) {
+        return "";
+    }
+
+    auto extension = std::string(".").append(filename.substr(0, dot));
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    return extension;
+}
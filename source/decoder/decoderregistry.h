@@ -0,0 +1,73 @@
+#pragma once
+
+#include "decoder.h"
+
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL2/SDL_mutex.h>
+
+// Pick a decoder for a file. Extensions are found in a perfect hash table built
+// once, the content first bytes are then ranked by each decoder sniff() so badly
+// named files still play. The winner is remembered per path and size for the
+// most recently found files.
+// Decoders are returned as an index in the list given to setup().
+class DecoderRegistry {
+
+    public:
+        DecoderRegistry();
+        virtual ~DecoderRegistry();
+
+        bool setup(const std::vector<std::shared_ptr<Decoder>>& decoderList);
+        void cleanup();
+
+        // From the name only, without any IO, -1 if none
+        int find(const std::filesystem::path& path) const;
+        // From the name and the content, -1 if none
+        int find(const std::filesystem::path& path, const FileView content);
+        // Drop the decoder remembered for path, for callers opening many songs once
+        // or when the decoder found cannot play it
+        void forget(const std::filesystem::path& path);
+
+    private:
+        static const int EXTENSION_SCORE;
+        static const int PREFIX_SCORE;
+        static const int MAX_SEED_TRIES;
+        static const size_t MAX_WINNERS;
+
+        struct Slot {
+            std::string extension = "";
+            int decoder = -1;
+        };
+
+        struct Winner {
+            std::string path;
+            size_t size;
+            int decoder;
+        };
+
+        std::vector<std::shared_ptr<Decoder>> mDecoderList;
+        std::vector<Slot> mSlots;
+        Uint32 mSeed;
+        Uint32 mMask;
+
+        // Most recently used first
+        std::list<Winner> mWinners;
+        std::unordered_map<std::string, std::list<Winner>::iterator> mWinnerIndexes;
+        SDL_mutex* mWinnersMutex;
+
+        DecoderRegistry(const DecoderRegistry& copy);
+
+        bool buildTable(const std::vector<Slot>& entries, const size_t size, const Uint32 seed);
+        int findExtension(const std::string& extension) const;
+        int findRemembered(const std::string& path, const size_t size);
+        void remember(const std::string& path, const size_t size, const int decoder);
+
+        static Uint32 hash(const std::string& key, const Uint32 seed);
+        static std::string getExtension(const std::filesystem::path& path);
+        static std::string getPrefixExtension(const std::filesystem::path& path);
+
+};
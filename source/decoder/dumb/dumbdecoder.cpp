@@ -7,23 +7,41 @@
 
 const std::string DumbDecoder::NAME = "dumb";
 
+// dumb_exit and the rendering options are process wide
+DecoderLibrary DumbDecoder::sLibrary(
+    []() {
+        // Best quality, the value was clamped to it anyway
+        dumb_resampling_quality = DUMB_RQ_N_LEVELS - 1;
+        return true;
+    },
+    []() {
+        dumb_exit();
+    });
+
 DumbDecoder::DumbDecoder() :
     Decoder(),
     mDuh(nullptr),
     mDumbFile(nullptr),
-    mSigRenderer(nullptr) {
+    mSigRenderer(nullptr),
+    mIsSetup(false) {
 }
 
 DumbDecoder::~DumbDecoder() {
 }
 
 bool DumbDecoder::setup() {
-    dumb_resampling_quality = 48000;
-    return true;
+    if (!mIsSetup) {
+        mIsSetup = sLibrary.acquire();
+    }
+    return mIsSetup;
 }
 
 void DumbDecoder::cleanup() {
-    dumb_exit();
+    stop();
+    if (mIsSetup) {
+        mIsSetup = false;
+        sLibrary.release();
+    }
 }
 
 uint8_t DumbDecoder::getAudioChannels() const {
@@ -44,32 +62,55 @@ const Decoder::MetaData DumbDecoder::getMetaData() {
 }
 
 int DumbDecoder::getAudioFrequency() const {
-    return dumb_resampling_quality;
+    return DEFAULT_AUDIO_FREQUENCY;
 }
 
 std::string DumbDecoder::getName() const {
     return NAME;
 }
 
-bool DumbDecoder::canRead(const std::string extention) const {
-    if(extention == ".it") { return true; }
-    if(extention == ".xm") { return true; }
-    if(extention == ".mod") { return true; }
-    if(extention == ".stm") { return true; }
-    if(extention == ".s3m") { return true; }
-    if(extention == ".669") { return true; }
-    if(extention == ".amf") { return true; }
-    if(extention == ".dsm") { return true; }
-    if(extention == ".mtm") { return true; }
-    if(extention == ".okt") { return true; }
-    if(extention == ".psm") { return true; }
-    if(extention == ".ptm") { return true; }
-    if(extention == ".riff") { return true; }
-    return false;
+std::vector<std::string> DumbDecoder::getExtensions() const {
+    return {
+        ".it", ".xm", ".mod", ".stm", ".s3m", ".669", ".amf", ".dsm",
+        ".mtm", ".okt", ".psm", ".ptm", ".riff"
+    };
+}
+
+int DumbDecoder::sniff(const FileView content) const {
+    if (hasMagic(content, 0, "IMPM") || hasMagic(content, 0, "Extended Module: ")
+        || hasMagic(content, 44, "SCRM") || hasMagic(content, 0, "OKTASONG")) {
+        return 100;
+    }
+
+    if (hasMagic(content, 44, "PTMF") || hasMagic(content, 0, "MTM") || hasMagic(content, 0, "PSM ")
+        || (hasMagic(content, 0, "RIFF") && hasMagic(content, 8, "DSMF")) || hasMagic(content, 0, "DSMF")) {
+        return 90;
+    }
+
+    // Protracker and clones signature after the samples table
+    const char* modSignatures[] = { "M.K.", "M!K!", "M&K!", "N.T.", "FLT4", "FLT8", "4CHN", "6CHN", "8CHN", "CD81", "OKTA" };
+    for (const auto signature : modSignatures) {
+        if (hasMagic(content, 1080, signature)) {
+            return 80;
+        }
+    }
+
+    if (hasMagic(content, 20, "!Scream!") || hasMagic(content, 20, "BMOD2STM") || hasMagic(content, 0, "AMF")) {
+        return 70;
+    }
+
+    // Composer 669, two letters only
+    if (hasMagic(content, 0, "if") || hasMagic(content, 0, "JN")) {
+        return 10;
+    }
+
+    return 0;
 }
 
-bool DumbDecoder::play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) {
+bool DumbDecoder::play(const FileView content, std::shared_ptr<Settings> settings) {
+    // Read by DUMB while rendering, all instances share the last value set
     const auto maxToMix = settings->getInt(KEY_DUMB_MAX_TO_MIX, DUMB_MAX_TO_MIX_DEFAULT);
+    sLibrary.lock();
     switch(maxToMix) {
         case 0:
             dumb_it_max_to_mix = 64;
@@ -86,8 +127,9 @@ bool DumbDecoder::play(const std::vector<char> buffer, std::shared_ptr<Settings>
         default:
             dumb_it_max_to_mix = 64;
     }
+    sLibrary.unlock();
 
-    if (mDumbFile = dumbfile_open_memory(buffer.data(), buffer.size());
+    if (mDumbFile = dumbfile_open_memory(content.data, content.size);
         mDumbFile == nullptr) {
         
         mError = "Can't open file.";
@@ -101,10 +143,21 @@ bool DumbDecoder::play(const std::vector<char> buffer, std::shared_ptr<Settings>
         return false;
     }
 
+    // The module is fully read, don't keep a file on memory owned by the caller
+    dumbfile_close(mDumbFile);
+    mDumbFile = nullptr;
+
     mMetaData = MetaData();
     parseMetaData();
     mSigRenderer = duh_start_sigrenderer(mDuh, 0, 2, 0);
 
+    // Per renderer, not taken from the global when started
+    if (const auto itSigRenderer = mSigRenderer != nullptr ? duh_get_it_sigrenderer(mSigRenderer) : nullptr;
+        itSigRenderer != nullptr) {
+
+        dumb_it_set_resampling_quality(itSigRenderer, DUMB_RQ_N_LEVELS - 1);
+    }
+
     return true;
 }
 
@@ -129,7 +182,8 @@ int DumbDecoder::process(Uint8* stream, const int len) {
     if (mSigRenderer == nullptr) return -1;
 
     const auto toRender = len >> 2;
-    const auto rendered = duh_render(mSigRenderer, 16, 0, 1.0f, 65536.0f / 48000.0f, toRender, stream);
+    const auto rendered = duh_render(mSigRenderer, 16, 0, 1.0f, 65536.0f / DEFAULT_AUDIO_FREQUENCY, toRender, stream);
+    mRenderedLength = rendered << 2;
     if (rendered != toRender) {
         return 1;
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../decoder.h"
+#include "../decoderlibrary.h"
 #include "../../settings.h"
 
 #include <string>
@@ -25,9 +26,10 @@ class DumbDecoder : public Decoder {
         virtual uint8_t getAudioChannels() const override;
         virtual SDL_AudioFormat getAudioSampleFormat() const override;
 
-        virtual bool canRead(const std::string extention) const override;
+        virtual std::vector<std::string> getExtensions() const override;
+        virtual int sniff(const FileView content) const override;
         virtual const MetaData getMetaData() override;
-        virtual bool play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) override;
+        virtual bool play(const FileView content, std::shared_ptr<Settings> settings) override;
         virtual void stop() override;   
         virtual int process(Uint8* stream, const int len) override;
 
@@ -35,6 +37,9 @@ class DumbDecoder : public Decoder {
         DUH *mDuh;
         DUMBFILE *mDumbFile;
         DUH_SIGRENDERER *mSigRenderer;
+        bool mIsSetup;
+
+        static DecoderLibrary sLibrary;
 
         DumbDecoder(const DumbDecoder& copy);
 
@@ -43,7 +43,7 @@ const Decoder::MetaData GmeDecoder::getMetaData() {
 }
 
 int GmeDecoder::getAudioFrequency() const {
-    return 48000;
+    return DEFAULT_AUDIO_FREQUENCY;
 }
 
 std::string GmeDecoder::getName() const {
@@ -51,32 +51,47 @@ std::string GmeDecoder::getName() const {
 }
 
 
-bool GmeDecoder::canRead(const std::string extention) const {
-    if(extention == ".ay") { return true; }
-    if(extention == ".gbs") { return true; }
-    if(extention == ".gym") { return true; }
-    if(extention == ".hes") { return true; }
-    if(extention == ".kss") { return true; }
-    if(extention == ".nsf") { return true; }
-    if(extention == ".nsfe") { return true; }
-    if(extention == ".sap") { return true; }
-    if(extention == ".spc") { return true; }
-    if(extention == ".vgm") { return true; }
-    if(extention == ".vgz") { return true; } 
-    return false;
+std::vector<std::string> GmeDecoder::getExtensions() const {
+    return {
+        ".ay", ".gbs", ".gym", ".hes", ".kss", ".nsf", ".nsfe", ".sap",
+        ".spc", ".vgm", ".vgz"
+    };
 }
 
-bool GmeDecoder::play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) {
-    if (const auto header = gme_identify_header(buffer.data());
-        header[0] == '\0') {
+int GmeDecoder::sniff(const FileView content) const {
+    if (content.size < 4) {
+        return 0;
+    }
+
+    // gme knows the signature of every system it handles
+    if (const auto header = gme_identify_header(content.data);
+        header[0] != '\0') {
+
+        return 90;
+    }
+
+    return 0;
+}
 
+bool GmeDecoder::play(const FileView content, std::shared_ptr<Settings> settings) {
+    // The header is read without size check
+    if (content.size < 4 || gme_identify_header(content.data)[0] == '\0') {
         mError = gme_wrong_file_type;
         return false;
     }
 
-    if (const auto error = gme_open_data(buffer.data(), buffer.size(), &mMusicEmu, 48000);
-        error != nullptr) {
+    // The emulator of the previous song is reused when it is of the same system
+    const auto type = gme_identify_extension(gme_identify_header(content.data));
+    if (mMusicEmu != nullptr && gme_type(mMusicEmu) != type) {
+        gme_delete(mMusicEmu);
+        mMusicEmu = nullptr;
+    }
 
+    if (mMusicEmu == nullptr) {
+        mMusicEmu = gme_new_emu(type, DEFAULT_AUDIO_FREQUENCY);
+    }
+
+    if (mMusicEmu == nullptr || gme_load_data(mMusicEmu, content.data, content.size) != nullptr) {
         mError = "Can't open file.";
         return false;
     }
@@ -100,10 +115,7 @@ bool GmeDecoder::play(const std::vector<char> buffer, std::shared_ptr<Settings>
 }
 
 void GmeDecoder::stop() {
-    if (mMusicEmu != nullptr) {
-        gme_delete(mMusicEmu);
-        mMusicEmu = nullptr;
-    }
+    // Emulator kept for the next song, released by cleanup()
 }
 
 bool GmeDecoder::nextTrack() {
@@ -142,6 +154,21 @@ bool GmeDecoder::prevTrack() {
     return false;
 }
 
+bool GmeDecoder::seek(const int position) {
+    if (mMusicEmu == nullptr) {
+        return false;
+    }
+
+    if (const auto error = gme_seek(mMusicEmu, position * 1000);
+        error != nullptr) {
+
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "GME: %s", error);
+        return false;
+    }
+
+    return true;
+}
+
 int GmeDecoder::process(Uint8* stream, const int len) {
     if (mMusicEmu == nullptr) return -1;
 
@@ -152,10 +179,10 @@ int GmeDecoder::process(Uint8* stream, const int len) {
         return -1;
     }
 
+    // The caller starts the next track if it wants it, gme_start_track can take a while
+    mRenderedLength = len;
     if (gme_track_ended(mMusicEmu)) {
-        if (!nextTrack()) {
-            return 1;
-        }
+        return 1;
     }
 
     return 0;
@@ -189,6 +216,7 @@ void GmeDecoder::parseTrackMetaData() {
     mMetaData.trackInformation.copyright = info->copyright;
     mMetaData.trackInformation.duration = (info->length > 0 ? info->length : info->play_length) / 1000;
     mMetaData.trackInformation.trackNumber = mCurrentTrack+1;
+    mMetaData.trackInformation.seekable = true;
     mMetaData.trackInformation.comment = info->comment;
     gme_free_info(info);
 }
@@ -25,14 +25,16 @@ class GmeDecoder : public Decoder {
         virtual uint8_t getAudioChannels() const override;
         virtual SDL_AudioFormat getAudioSampleFormat() const override;
 
-        virtual bool canRead(const std::string extention) const override;
+        virtual std::vector<std::string> getExtensions() const override;
+        virtual int sniff(const FileView content) const override;
         virtual const MetaData getMetaData() override;
-        virtual bool play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) override;
+        virtual bool play(const FileView content, std::shared_ptr<Settings> settings) override;
         virtual void stop() override;   
         virtual int process(Uint8* stream, const int len) override;
 
         virtual bool nextTrack() override;
         virtual bool prevTrack() override;
+        virtual bool seek(const int position) override;
 
     private:
         Music_Emu* mMusicEmu;
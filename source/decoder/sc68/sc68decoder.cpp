@@ -7,8 +7,19 @@
 
 const std::string Sc68Decoder::NAME = "sc68";
 
+// sc68_init and sc68_shutdown are process wide, more than one instance can be alive
+DecoderLibrary Sc68Decoder::sLibrary(
+    []() {
+        return sc68_init(0) == 0;
+    },
+    []() {
+        sc68_shutdown();
+    });
+
 Sc68Decoder::Sc68Decoder() :
     Decoder(),
+    mCurrentTrack(0),
+    mIsSongLoaded(false),
     mSC68(nullptr) {
 }
 
@@ -16,17 +27,23 @@ Sc68Decoder::~Sc68Decoder() {
 }
 
 bool Sc68Decoder::setup() {
-    if(sc68_init(0)) {
+    // Instance kept between songs
+    if (mSC68 != nullptr) {
+        return true;
+    }
+
+    if (!sLibrary.acquire()) {
         mError = "init sc68 error.";
         return false;
     }
 
     memset(&mSC68Config, 0, sizeof(mSC68Config));
-    mSC68Config.sampling_rate = 48000;
+    mSC68Config.sampling_rate = DEFAULT_AUDIO_FREQUENCY;
     if (mSC68 = sc68_create(&mSC68Config),
         mSC68 == nullptr) {
 
         mError = sc68_error(mSC68);
+        sLibrary.release();
         return false;
     }
 
@@ -35,9 +52,12 @@ bool Sc68Decoder::setup() {
 
 void Sc68Decoder::cleanup() {
     if (mSC68 != nullptr) {
+        if (mIsSongLoaded) {
+            stop();
+        }
         sc68_destroy(mSC68);
-        sc68_shutdown();
         mSC68 = nullptr;
+        sLibrary.release();
     }
 }
 
@@ -66,15 +86,31 @@ std::string Sc68Decoder::getName() const {
     return NAME;
 }
 
-bool Sc68Decoder::canRead(const std::string extention) const {
-    if(extention == ".snd") { return true; }
-    if(extention == ".sndh") { return true; }
-    if(extention == ".sc68") { return true; }
-    return false;
+std::vector<std::string> Sc68Decoder::getExtensions() const {
+    return {
+        ".snd", ".sndh", ".sc68"
+    };
 }
 
-bool Sc68Decoder::play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) {
-    if (sc68_load_mem(mSC68, buffer.data(), buffer.size()) != 0) {
+int Sc68Decoder::sniff(const FileView content) const {
+    if (hasMagic(content, 0, "SC68 Music-file")) {
+        return 100;
+    }
+
+    if (hasMagic(content, 12, "SNDH")) {
+        return 90;
+    }
+
+    // ICE packed files, depacked by sc68 but could be anything
+    if (hasMagic(content, 0, "ICE!") || hasMagic(content, 0, "Ice!")) {
+        return 50;
+    }
+
+    return 0;
+}
+
+bool Sc68Decoder::play(const FileView content, std::shared_ptr<Settings> settings) {
+    if (sc68_load_mem(mSC68, content.data, content.size) != 0) {
         mIsSongLoaded = false;
         mError = sc68_error(mSC68);
         return false;
@@ -145,7 +181,8 @@ int Sc68Decoder::process(Uint8* stream, const int len) {
 
     auto amount = len >> 2;
     auto retCode = sc68_process(mSC68, stream, &amount);
-    
+    mRenderedLength = amount << 2;
+
     if ((retCode & SC68_END)) {
         return 1;
     }
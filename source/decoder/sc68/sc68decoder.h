@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../decoder.h"
+#include "../decoderlibrary.h"
 #include "../../settings.h"
 
 #include <string>
@@ -25,9 +26,10 @@ class Sc68Decoder : public Decoder {
         virtual uint8_t getAudioChannels() const override;
         virtual SDL_AudioFormat getAudioSampleFormat() const override;
 
-        virtual bool canRead(const std::string extention) const override;
+        virtual std::vector<std::string> getExtensions() const override;
+        virtual int sniff(const FileView content) const override;
         virtual const MetaData getMetaData() override;
-        virtual bool play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) override;
+        virtual bool play(const FileView content, std::shared_ptr<Settings> settings) override;
         virtual void stop() override;   
         virtual int process(Uint8* stream, const int len) override;
 
@@ -40,6 +42,8 @@ class Sc68Decoder : public Decoder {
         sc68_create_t mSC68Config;
         sc68_t* mSC68;
 
+        static DecoderLibrary sLibrary;
+
         Sc68Decoder(const Sc68Decoder& copy);
         void parseDiskMetaData();
         void parseTrackMetaData(int track);
@@ -4,7 +4,6 @@
 #include "sidplayfp_settings_strings.h"
 
 #include <fstream>
-#include <sidplayfp/SidConfig.h>
 #include <sidplayfp/SidInfo.h>
 #include <sidplayfp/SidTuneInfo.h>
 #include <sidplayfp/builders/residfp.h>
@@ -13,6 +12,10 @@
 #include <SDL2/SDL_log.h>
 
 const std::string SidPlayDecoder::NAME = "sidplayfp";
+// Maximum speed supported by sidplayfp (percent)
+const int SidPlayDecoder::SEEK_FAST_FORWARD = 3200;
+// Small chunks so we don't overshoot the target by more than a fraction of a second
+const int SidPlayDecoder::SEEK_BUFFER_SAMPLES = 1024;
 
 SidPlayDecoder::SidPlayDecoder(const std::string dataPath) :
     Decoder(),
@@ -21,7 +24,10 @@ SidPlayDecoder::SidPlayDecoder(const std::string dataPath) :
     mChargenRom(std::shared_ptr<char[]>(loadRom(std::string(dataPath).append("/chargen").c_str(), 4096))),
     mPlayer(nullptr),
     mSIDBuilder(nullptr),
-    mTune(nullptr) {
+    mSIDEmulation(-1),
+    mIsConfigured(false),
+    mTune(nullptr),
+    mSeekBuffer(SEEK_BUFFER_SAMPLES) {
 
 }
 
@@ -29,13 +35,20 @@ SidPlayDecoder::~SidPlayDecoder() {
 }
 
 bool SidPlayDecoder::setup() {
+    // Player and SID chips are kept between songs
+    if (mPlayer != nullptr) {
+        return true;
+    }
+
     mPlayer = std::unique_ptr<sidplayfp>(new sidplayfp());
+    mIsConfigured = false;
     mPlayer->setRoms((const uint8_t*) mKernalRom.get(), (const uint8_t*) mBasicRom.get(), (const uint8_t*) mChargenRom.get());
 
     return true;
 }
 
 void SidPlayDecoder::cleanup() {
+    // Player first, it still references the builder chips
     if (mPlayer != nullptr) {
         mPlayer = nullptr;
     }
@@ -47,6 +60,8 @@ void SidPlayDecoder::cleanup() {
     if (mSIDBuilder != nullptr) {
         mSIDBuilder = nullptr;
     }
+    mSIDEmulation = -1;
+    mIsConfigured = false;
 }
 
 uint8_t SidPlayDecoder::getAudioChannels() const {
@@ -74,30 +89,45 @@ std::string SidPlayDecoder::getName() const {
     return NAME;
 }
 
-bool SidPlayDecoder::canRead(const std::string extention) const {
-    if(extention == ".sid") { return true; }
-    if(extention == ".psid") { return true; }
-    if(extention == ".rsid") { return true; }
-    if(extention == ".mus") { return true; }
-    return false;
+std::vector<std::string> SidPlayDecoder::getExtensions() const {
+    return {
+        ".sid", ".psid", ".rsid", ".mus"
+    };
 }
 
-bool SidPlayDecoder::play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) {
-    const auto sidEmulation = settings->getInt(KEY_SIDPLAYFP_SID_EMULATION, SIDPLAYFP_SID_EMULATION_DEFAULT);
-    switch (sidEmulation) {
-        case 1:
-            mSIDBuilder = std::unique_ptr<sidbuilder>(new ReSIDBuilder("OSP"));
-            break;
-        default:
-        case 0:
-            mSIDBuilder = std::unique_ptr<sidbuilder>(new ReSIDfpBuilder("OSP"));
-            break;
+int SidPlayDecoder::sniff(const FileView content) const {
+    if (hasMagic(content, 0, "PSID") || hasMagic(content, 0, "RSID")) {
+        return 100;
     }
 
-    mSIDBuilder->create(mPlayer->info().maxsids());
-    if (!mSIDBuilder->getStatus()) {
-        mError = mSIDBuilder->error();
-        return false;
+    return 0;
+}
+
+bool SidPlayDecoder::play(const FileView content, std::shared_ptr<Settings> settings) {
+    // Building the chips compute their filter tables, only do it when the emulation change.
+    // The previous builder must outlive the player reconfiguration that releases its chips.
+    std::unique_ptr<sidbuilder> previousBuilder;
+    if (const auto sidEmulation = settings->getInt(KEY_SIDPLAYFP_SID_EMULATION, SIDPLAYFP_SID_EMULATION_DEFAULT);
+        mSIDBuilder == nullptr || sidEmulation != mSIDEmulation) {
+
+        previousBuilder = std::move(mSIDBuilder);
+        switch (sidEmulation) {
+            case 1:
+                mSIDBuilder = std::unique_ptr<sidbuilder>(new ReSIDBuilder("OSP"));
+                break;
+            default:
+            case 0:
+                mSIDBuilder = std::unique_ptr<sidbuilder>(new ReSIDfpBuilder("OSP"));
+                break;
+        }
+
+        mSIDBuilder->create(mPlayer->info().maxsids());
+        if (!mSIDBuilder->getStatus()) {
+            mError = mSIDBuilder->error();
+            mSIDBuilder = std::move(previousBuilder);
+            return false;
+        }
+        mSIDEmulation = sidEmulation;
     }
 
     const auto samplingMethod = (SidConfig::sampling_method_t) settings->getInt(KEY_SIDPLAYFP_SAMPLING_METHOD, SIDPLAYFP_SAMPLING_METHOD_DEFAULT);
@@ -106,20 +136,32 @@ bool SidPlayDecoder::play(const std::vector<char> buffer, std::shared_ptr<Settin
     const auto defaultSong = settings->getBool(KEY_APP_ALWAYS_START_FIRST_TUNE, APP_ALWAYS_START_FIRST_TUNE_DEFAULT) ? 0 : 1;
 
     SidConfig cfg;
-    cfg.frequency = 48000;
+    cfg.frequency = DEFAULT_AUDIO_FREQUENCY;
     cfg.samplingMethod = samplingMethod;
     cfg.fastSampling = fastSampling;
     cfg.digiBoost = enableDigiboost;
     cfg.playback = SidConfig::STEREO;
     cfg.sidEmulation = mSIDBuilder.get();
-    
-    if (!mPlayer->config(cfg)) {
-        mError = mPlayer->error();
-        return false;
+
+    // Only reconfigure the player when a setting changed since the previous song
+    if (!mIsConfigured || mConfig.compare(cfg)) {
+        mIsConfigured = false;
+        if (!mPlayer->config(cfg)) {
+            mError = mPlayer->error();
+            return false;
+        }
+        mConfig = cfg;
+        mIsConfigured = true;
     }
 
-    if (mTune = std::unique_ptr<SidTune>(new SidTune((const uint_least8_t*) buffer.data(), buffer.size()));
-        mTune->getStatus() == false) {
+    // The tune object is kept too, only its content is replaced
+    if (mTune == nullptr) {
+        mTune = std::unique_ptr<SidTune>(new SidTune((const uint_least8_t*) content.data, content.size));
+    } else {
+        mTune->read((const uint_least8_t*) content.data, content.size);
+    }
+
+    if (!mTune->getStatus()) {
         mError = mTune->statusString();
         return false;
     }
@@ -151,16 +193,8 @@ bool SidPlayDecoder::nextTrack() {
     
     if (const auto musicInfo = mTune->getInfo();
         (int) musicInfo->currentSong() < mMetaData.diskInformation.trackCount) {
-        
-        mPlayer->load(nullptr);
-        if (mTune->selectSong(musicInfo->currentSong()+1) == 0) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SIDPLAYFP: %s\n", mTune->statusString());
-            return false;
-        }
 
-        mPlayer->load(mTune.get());
-        parseTrackMetaData();
-        return true;
+        return selectTrack(musicInfo->currentSong()+1);
     }
 
     return false;
@@ -174,18 +208,58 @@ bool SidPlayDecoder::prevTrack() {
     if (const auto musicInfo = mTune->getInfo();
         musicInfo->currentSong() > 1) {
 
-        mPlayer->load(nullptr);
-        if (mTune->selectSong(musicInfo->currentSong()-1) == 0) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SIDPLAYFP: %s\n", mTune->statusString());
+        return selectTrack(musicInfo->currentSong()-1);
+    }
+
+    return false;
+}
+
+bool SidPlayDecoder::selectTrack(const unsigned int track) {
+    // Same tune and chips, the player only reset the C64 and starts the sub tune
+    if (mTune->selectSong(track) == 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SIDPLAYFP: %s\n", mTune->statusString());
+        return false;
+    }
+
+    if (!mPlayer->load(mTune.get())) {
+        mError = mPlayer->error();
+        return false;
+    }
+
+    parseTrackMetaData();
+    return true;
+}
+
+bool SidPlayDecoder::seek(const int position) {
+    if (mPlayer == nullptr || mTune == nullptr || position < 0) {
+        return false;
+    }
+
+    // sidplayfp cannot save the emulator state, so the current position is the
+    // only checkpoint we have: going backward restart the sub tune from its beginning.
+    if (position < (int) mPlayer->time()) {
+        if (!mPlayer->load(mTune.get())) {
+            mError = mPlayer->error();
             return false;
         }
+    }
 
-        mPlayer->load(mTune.get());
-        parseTrackMetaData();
-        return true;
+    // Emulate the remaining time as fast as possible, the output is discarded
+    mPlayer->fastForward(SEEK_FAST_FORWARD);
+    auto retCode = true;
+    while ((int) mPlayer->time() < position) {
+        if (mPlayer->play(mSeekBuffer.data(), mSeekBuffer.size()) < mSeekBuffer.size()) {
+            // Went past the end of the tune or failed
+            retCode = !mPlayer->isPlaying();
+            if (!retCode) {
+                mError = mPlayer->error();
+            }
+            break;
+        }
     }
+    mPlayer->fastForward(100);
 
-    return false;
+    return retCode;
 }
 
 int SidPlayDecoder::process(Uint8* stream, const int len) {
@@ -193,6 +267,7 @@ int SidPlayDecoder::process(Uint8* stream, const int len) {
 
     unsigned int sz = len >> 1;
     unsigned int played = mPlayer->play((short*) stream, sz);
+    mRenderedLength = played << 1;
 
     if(played < sz && mPlayer->isPlaying()) {
         mError = mPlayer->error();
@@ -232,6 +307,7 @@ void SidPlayDecoder::parseTrackMetaData() {
     mMetaData.trackInformation.copyright = musicInfo->infoString(2);
     mMetaData.trackInformation.duration = 0; // todo: how to get it ?
     mMetaData.trackInformation.trackNumber = musicInfo->currentSong();
+    mMetaData.trackInformation.seekable = true;
 }
 
 char* SidPlayDecoder::loadRom(const std::string path, const size_t romSize) {
@@ -7,6 +7,7 @@
 #include <vector>
 #include <memory>                    
 #include <sidplayfp/sidplayfp.h>
+#include <sidplayfp/SidConfig.h>
 #include <sidplayfp/SidTune.h>
 #include <sidplayfp/sidbuilder.h>
 #include <SDL2/SDL_audio.h>
@@ -15,6 +16,8 @@ class SidPlayDecoder : public Decoder {
 
     public:
         static const std::string NAME;
+        static const int SEEK_FAST_FORWARD;
+        static const int SEEK_BUFFER_SAMPLES;
 
         SidPlayDecoder(const std::string dataPath);
         virtual ~SidPlayDecoder();
@@ -27,14 +30,16 @@ class SidPlayDecoder : public Decoder {
         virtual uint8_t getAudioChannels() const override;
         virtual SDL_AudioFormat getAudioSampleFormat() const override;
       
-        virtual bool canRead(const std::string extention) const override;
+        virtual std::vector<std::string> getExtensions() const override;
+        virtual int sniff(const FileView content) const override;
         virtual const MetaData getMetaData() override;
-        virtual bool play(const std::vector<char> buffer, std::shared_ptr<Settings> settings) override;
+        virtual bool play(const FileView content, std::shared_ptr<Settings> settings) override;
         virtual void stop() override;
         virtual int process(Uint8* stream, const int len) override;
 
         virtual bool nextTrack() override;
         virtual bool prevTrack() override;
+        virtual bool seek(const int position) override;
 
     private:
         std::shared_ptr<char[]> mKernalRom;
@@ -43,10 +48,15 @@ class SidPlayDecoder : public Decoder {
 
         std::unique_ptr<sidplayfp> mPlayer;
         std::unique_ptr<sidbuilder> mSIDBuilder;
+        int mSIDEmulation;
+        SidConfig mConfig;
+        bool mIsConfigured;
         std::unique_ptr<SidTune> mTune;
+        std::vector<short> mSeekBuffer;
 
         SidPlayDecoder(const SidPlayDecoder& copy);
 
+        bool selectTrack(const unsigned int track);
         void parseDiskMetaData();
         void parseTrackMetaData();
 
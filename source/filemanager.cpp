@@ -1,15 +1,19 @@
 #include "filemanager.h"
 
+#include "filesystem/collation.h"
 #include "filesystem/local/localfilesystem.h"
+#include "filesystem/zip/zipfilesystem.h"
 #include "platform.h"
 #include "strings.h"
 
-#include <algorithm>
+#include <iterator>
 #include <SDL2/SDL_log.h>
 
 FileManager::FileManager() :
     mStateMutex(SDL_CreateMutex()),
     mFileSystemThread(nullptr), 
+    mCurrentPathEntries(std::make_shared<const std::vector<FileSystem::Entry>>()),
+    mListingGeneration(0),
     mCurrentFileSystem(nullptr) {
 }
 
@@ -39,11 +43,12 @@ void FileManager::cleanup() {
     }
 
     mCurrentPathStack.clear();
-    mCurrentPathEntries.clear();
+    publishListing(std::make_shared<const std::vector<FileSystem::Entry>>());
     mFileSystemList.clear();
     mLastFolder.clear();
 
     mCurrentFileSystem = nullptr;
+    mIndexedNavigation = nullptr;
     for (const auto fileSystem : mFileSystemList) {
         fileSystem->cleanup();
     }
@@ -66,6 +71,14 @@ void FileManager::clearError() {
 }
 
 
+std::vector<std::shared_ptr<FileSystem>> FileManager::getFileSystems() const {
+    return mFileSystemList;
+}
+
+void FileManager::setIndexedNavigation(const std::function<bool (const std::string, std::vector<FileSystem::Entry>&)>& navigate) {
+    mIndexedNavigation = navigate;
+}
+
 std::filesystem::path FileManager::getCurrentPath() const {
     return mCurrentPath;
 }
@@ -74,22 +87,33 @@ std::string FileManager::getLastFolder() const {
     return mLastFolder.empty() ? "" : mLastFolder.back();
 };
 
-std::vector<FileSystem::Entry> FileManager::getCurrentPathEntries() const {
-    return mCurrentPathEntries;
+FileManager::Listing FileManager::getCurrentPathEntries() const {
+    return std::atomic_load(&mCurrentPathEntries);
+}
+
+Uint32 FileManager::getListingGeneration() const {
+    return mListingGeneration.load(std::memory_order_acquire);
+}
+
+void FileManager::publishListing(Listing listing) {
+    std::atomic_store(&mCurrentPathEntries, listing);
+    mListingGeneration.fetch_add(1, std::memory_order_release);
 }
 
 void FileManager::clearPath() {
     mCurrentFileSystem = nullptr;
     mCurrentPathStack.clear();
-    mCurrentPathEntries.clear();
     mLastFolder.clear();
+
+    auto listing = std::make_shared<std::vector<FileSystem::Entry>>();
     for (const auto fileSystem : mFileSystemList) {
-        mCurrentPathEntries.push_back({
+        listing->push_back({
             .folder = true,
             .name = fileSystem->getMountPoint(),
             .size = 0 
         });
     }
+    publishListing(listing);
 }
 
 void FileManager::buildPath() {
@@ -161,6 +185,15 @@ std::shared_ptr<File> FileManager::getFile(const std::string path) {
         return mCurrentFileSystem->getFile(path);
     }
 
+    // Queued songs can be played from the mount points list
+    for (const auto fileSystem : mFileSystemList) {
+        if (const auto mountPoint = fileSystem->getMountPoint();
+            path.compare(0, mountPoint.size(), mountPoint) == 0) {
+
+            return fileSystem->getFile(path);
+        }
+    }
+
     SDL_LockMutex(mStateMutex);
     mError = STR_ERROR_NO_FILESYSTEM;
     mState = ERROR;
@@ -170,7 +203,9 @@ std::shared_ptr<File> FileManager::getFile(const std::string path) {
 }
 
 bool FileManager::initializeFileSystems() {
-    if (const auto fileSystem = std::shared_ptr<FileSystem>(new LocalFileSystem(DEFAULT_LOCAL_FS_PATH));
+    // Zip files are browsed as folders of the local file system
+    if (const auto fileSystem = std::shared_ptr<FileSystem>(new ZipFileSystem(
+            std::shared_ptr<FileSystem>(new LocalFileSystem(DEFAULT_LOCAL_FS_PATH))));
         fileSystem->setup() == false) {
 
         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Cannot load LocalFileSystem (%s).\n", DEFAULT_LOCAL_FS_PATH);
@@ -212,17 +247,11 @@ int FileManager::fileSystemThreadFunc(void* userData) {
     fileManager->mError = "";
     SDL_UnlockMutex(fileManager->mStateMutex);
 
-    // Insert back navigation
-    fileManager->mCurrentPathEntries.clear();
-    fileManager->mCurrentPathEntries.insert(fileManager->mCurrentPathEntries.begin(), {
-        .folder = true,
-        .name = "..",
-        .size = 0
-    });
-
-    // Get listing from filesystem
+    // Get listing from the library index or the filesystem, the previous one stays visible meanwhile
     std::vector<FileSystem::Entry> list;
-    if (!fileManager->mCurrentFileSystem->navigate(fileManager->mCurrentPath, list)) {
+    if ((fileManager->mIndexedNavigation == nullptr || !fileManager->mIndexedNavigation(fileManager->mCurrentPath, list)) &&
+        !fileManager->mCurrentFileSystem->navigate(fileManager->mCurrentPath, list)) {
+
         SDL_LockMutex(fileManager->mStateMutex);
         fileManager->mState = ERROR;
         fileManager->mError = std::string(STR_ERROR_CANNOT_NAVIGATE).append(" : ").append(fileManager->mCurrentFileSystem->getError());
@@ -230,15 +259,19 @@ int FileManager::fileSystemThreadFunc(void* userData) {
         return 0;
     }
 
-    // sort by folder and filename asc
-    std::sort(list.begin(), list.end(), [](FileSystem::Entry a, FileSystem::Entry b) {
-        if (a.folder != b.folder) return a.folder;
-        std::transform(a.name.begin(), a.name.end(), a.name.begin(), ::tolower);
-        std::transform(b.name.begin(), b.name.end(), b.name.begin(), ::tolower);
-        return a.name < b.name;
+    Collation::sort(list);
+
+    // Insert back navigation
+    auto listing = std::make_shared<std::vector<FileSystem::Entry>>();
+    listing->reserve(list.size() + 1);
+    listing->push_back({
+        .folder = true,
+        .name = "..",
+        .size = 0
     });
+    listing->insert(listing->end(), std::make_move_iterator(list.begin()), std::make_move_iterator(list.end()));
 
-    fileManager->mCurrentPathEntries.insert(fileManager->mCurrentPathEntries.end(), list.begin(), list.end());
+    fileManager->publishListing(listing);
 
     SDL_LockMutex(fileManager->mStateMutex);
     fileManager->mState = READY;
@@ -5,6 +5,8 @@
 
 #include <string>
 #include <filesystem>
+#include <atomic>
+#include <functional>
 #include <list>
 #include <vector>
 #include <memory>
@@ -20,6 +22,9 @@ class FileManager {
             ERROR
         };
 
+        // Immutable, replaced as a whole when a navigation completes
+        typedef std::shared_ptr<const std::vector<FileSystem::Entry>> Listing;
+
         FileManager();
         virtual ~FileManager();
 
@@ -28,12 +33,16 @@ class FileManager {
    
         std::string getLastFolder() const;
         std::filesystem::path getCurrentPath() const;
-        std::vector<FileSystem::Entry> getCurrentPathEntries() const;
+        Listing getCurrentPathEntries() const;
+        Uint32 getListingGeneration() const;
         bool navigate(const std::string path);
         std::shared_ptr<File> getFile(const std::string path);
         State getState() const;
         std::string getError() const;
         void clearError();
+        std::vector<std::shared_ptr<FileSystem>> getFileSystems() const;
+        // Tried before the file system, which lists the folder when it returns false
+        void setIndexedNavigation(const std::function<bool (const std::string, std::vector<FileSystem::Entry>&)>& navigate);
 
     private:
         SDL_mutex* mStateMutex;
@@ -44,16 +53,19 @@ class FileManager {
         std::list<std::string> mCurrentPathStack;
         std::list<std::string> mLastFolder;
         std::filesystem::path mCurrentPath;
-        std::vector<FileSystem::Entry> mCurrentPathEntries;
+        Listing mCurrentPathEntries;
+        std::atomic<Uint32> mListingGeneration;
         
         std::vector<std::shared_ptr<FileSystem>> mFileSystemList;
         std::shared_ptr<FileSystem> mCurrentFileSystem;
+        std::function<bool (const std::string, std::vector<FileSystem::Entry>&)> mIndexedNavigation;
         
         FileManager(const FileManager& copy);
   
         bool initializeFileSystems();
         void clearPath();
         void buildPath();
+        void publishListing(Listing listing);
         bool startWorkingThread();
 
         static int fileSystemThreadFunc(void* userData);
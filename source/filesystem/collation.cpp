@@ -0,0 +1,107 @@
+#include "collation.h"
+
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <SDL2/SDL_cpuinfo.h>
+#include <SDL2/SDL_thread.h>
+
+// Below this the cost of a thread is higher than the time saved
+const size_t Collation::PARALLEL_SORT_THRESHOLD = 8192;
+
+std::string Collation::getKey(const std::string& name) {
+    std::string key;
+    key.reserve(name.size() + 8);
+
+    for (size_t i=0; i<name.size();) {
+        const auto c = (unsigned char) name[i];
+        if (!std::isdigit(c)) {
+            key.push_back((char) std::tolower(c));
+            i++;
+            continue;
+        }
+
+        // Digit run without its leading zeros, prefixed by its length so a
+        // longer number is always greater. The '0' marker keeps numbers
+        // before letters as a plain comparison did.
+        auto start = i;
+        while (i < name.size() && std::isdigit((unsigned char) name[i])) {
+            i++;
+        }
+        while (start + 1 < i && name[start] == '0') {
+            start++;
+        }
+
+        const auto length = std::min(i - start, (size_t) 0xFFFF);
+        key.push_back('0');
+        key.push_back((char) (length >> 8));
+        key.push_back((char) (length & 0xFF));
+        key.append(name, start, length);
+    }
+
+    return key;
+}
+
+void Collation::sort(std::vector<FileSystem::Entry>& entries) {
+    // Folders first, the first key byte is enough to separate them
+    std::vector<Item> items;
+    items.reserve(entries.size());
+    for (size_t i=0; i<entries.size(); i++) {
+        items.push_back({
+            .key = std::string(1, entries[i].folder ? '0' : '1').append(getKey(entries[i].name)),
+            .index = (Uint32) i
+        });
+    }
+
+    sortItems(items);
+
+    std::vector<FileSystem::Entry> sorted;
+    sorted.reserve(entries.size());
+    for (const auto& item : items) {
+        sorted.push_back(std::move(entries[item.index]));
+    }
+    entries.swap(sorted);
+}
+
+bool Collation::compare(const Item& a, const Item& b) {
+    if (const auto result = a.key.compare(b.key);
+        result != 0) {
+
+        return result < 0;
+    }
+
+    // Same key ("track02" and "track2"), keep the listing order stable
+    return a.index < b.index;
+}
+
+void Collation::sortItems(std::vector<Item>& items) {
+    if (items.size() < PARALLEL_SORT_THRESHOLD || SDL_GetCPUCount() < 2) {
+        std::sort(items.begin(), items.end(), compare);
+        return;
+    }
+
+    // Upper half sorted by another thread, then both halves merged
+    std::vector<Item> upper(std::make_move_iterator(items.begin() + items.size() / 2),
+        std::make_move_iterator(items.end()));
+    items.resize(items.size() / 2);
+
+    const auto thread = SDL_CreateThread(Collation::sortThreadFunc, "OSP-Sort-Thread", &upper);
+    if (thread == nullptr) {
+        sortThreadFunc(&upper);
+    }
+    std::sort(items.begin(), items.end(), compare);
+    if (thread != nullptr) {
+        SDL_WaitThread(thread, nullptr);
+    }
+
+    const auto middle = items.size();
+    items.insert(items.end(), std::make_move_iterator(upper.begin()), std::make_move_iterator(upper.end()));
+    std::inplace_merge(items.begin(), items.begin() + middle, items.end(), compare);
+}
+
+int Collation::sortThreadFunc(void* userData) {
+    const auto items = static_cast<std::vector<Item>*>(userData);
+    std::sort(items->begin(), items->end(), compare);
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "filesystem.h"
+
+#include <string>
+#include <vector>
+#include <SDL2/SDL_stdinc.h>
+
+// Listing order: folders first, then names case folded with digit runs
+// compared by value so "track2" comes before "track10".
+// Keys are computed once per entry, sorting only moves key/index pairs.
+class Collation {
+
+    public:
+        static std::string getKey(const std::string& name);
+        static void sort(std::vector<FileSystem::Entry>& entries);
+
+    private:
+        static const size_t PARALLEL_SORT_THRESHOLD;
+
+        struct Item {
+            std::string key;
+            Uint32 index;
+        };
+
+        Collation();
+
+        static bool compare(const Item& a, const Item& b);
+        static void sortItems(std::vector<Item>& items);
+        static int sortThreadFunc(void* userData);
+
+};
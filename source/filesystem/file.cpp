@@ -1,5 +1,7 @@
 #include "file.h"
 
+#include "unpacker.h"
+
 File::File(const std::filesystem::path path) :
     mPath(path) {
 }
@@ -14,3 +16,22 @@ std::filesystem::path File::getPath() const {
 std::string File::getError() const {
     return mError;
 }
+
+std::shared_ptr<FileContent> File::getContent() {
+    // Shared by all files so every reader of a song finds it unpacked
+    static Unpacker unpacker;
+
+    const auto content = readContent();
+    return content != nullptr ? unpacker.unpack(content) : nullptr;
+}
+
+std::shared_ptr<FileContent> File::readContent() {
+    std::vector<char> buffer;
+    if (!getAsBuffer(buffer)) {
+        return nullptr;
+    }
+
+    const auto content = std::make_shared<FileContent>();
+    content->assign(std::move(buffer));
+    return content;
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "filecontent.h"
+
 #include <filesystem>
+#include <memory>
 #include <vector>
 
 class File {
@@ -9,7 +12,10 @@ class File {
         File(const std::filesystem::path path);
         virtual ~File();
 
+        // Raw bytes, as stored
         virtual bool getAsBuffer(std::vector<char>& buffer) = 0;
+        // Read only content without copy where possible, unpacked when packed, nullptr on error
+        std::shared_ptr<FileContent> getContent();
 
         std::filesystem::path getPath() const;
         std::string getError() const;
@@ -17,6 +23,9 @@ class File {
     protected:
         std::filesystem::path mPath;
         std::string mError;
+
+        // Raw content, without copy where the file system allows it
+        virtual std::shared_ptr<FileContent> readContent();
         
     private:
         File(const File& copy);
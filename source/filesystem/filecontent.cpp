@@ -0,0 +1,109 @@
+#include "filecontent.h"
+
+#include "../platform.h"
+
+#include <fstream>
+
+#if PLATFORM_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const size_t FileContent::MAP_MIN_SIZE = 64 * 1024;
+
+FileContent::FileContent() :
+    mMapping(nullptr),
+    mMappingSize(0) {
+}
+
+FileContent::~FileContent() {
+    release();
+}
+
+bool FileContent::map(const std::filesystem::path path) {
+    release();
+
+#if PLATFORM_HAS_MMAP
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        mError = path;
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t) MAP_MIN_SIZE) {
+        close(fd);
+        return read(path);
+    }
+
+    // The mapping stays valid once the file is closed
+    const auto mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return read(path);
+    }
+
+    // Decoders parse it from the start. Advices are values, not flags, one call each.
+    madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL);
+    madvise(mapping, fileStat.st_size, MADV_WILLNEED);
+    mMapping = mapping;
+    mMappingSize = fileStat.st_size;
+    return true;
+#else
+    return read(path);
+#endif
+}
+
+void FileContent::assign(std::vector<char>&& buffer) {
+    release();
+    mBuffer = std::move(buffer);
+}
+
+FileView FileContent::getView() const {
+    if (mMapping != nullptr) {
+        return { (const char*) mMapping, mMappingSize };
+    }
+
+    return FileView::of(mBuffer);
+}
+
+bool FileContent::isMapped() const {
+    return mMapping != nullptr;
+}
+
+std::string FileContent::getError() const {
+    return mError;
+}
+
+bool FileContent::read(const std::filesystem::path path) {
+    std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.good()) {
+        mError = path;
+        return false;
+    }
+
+    // Straight into the final buffer
+    mBuffer.resize(ifs.tellg());
+    ifs.seekg(0, std::ios::beg);
+    if (!ifs.read(mBuffer.data(), mBuffer.size())) {
+        mBuffer.clear();
+        mError = path;
+        return false;
+    }
+
+    return true;
+}
+
+void FileContent::release() {
+#if PLATFORM_HAS_MMAP
+    if (mMapping != nullptr) {
+        munmap(mMapping, mMappingSize);
+    }
+#endif
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mBuffer.clear();
+    mBuffer.shrink_to_fit();
+}
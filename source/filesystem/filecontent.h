@@ -0,0 +1,39 @@
+#pragma once
+
+#include "fileview.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Read only content of a file, kept until the instance is destroyed. Big local
+// files are memory mapped where the platform allows it, so decoders read them
+// from the page cache, the others are held in memory.
+class FileContent {
+
+    public:
+        FileContent();
+        virtual ~FileContent();
+
+        bool map(const std::filesystem::path path);
+        void assign(std::vector<char>&& buffer);
+
+        FileView getView() const;
+        bool isMapped() const;
+        std::string getError() const;
+
+    private:
+        // Below it, reading is cheaper than setting up a mapping
+        static const size_t MAP_MIN_SIZE;
+
+        void* mMapping;
+        size_t mMappingSize;
+        std::vector<char> mBuffer;
+        std::string mError;
+
+        FileContent(const FileContent& copy);
+
+        bool read(const std::filesystem::path path);
+        void release();
+
+};
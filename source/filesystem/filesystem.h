@@ -13,6 +13,8 @@ class FileSystem {
             bool folder;
             std::string name;
             uintmax_t size;
+            // Only compared for equality, in the file system own unit
+            int64_t modified = 0;
         };
 
         FileSystem();
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Non owning read only view on a file content, it must not outlive what it points to
+struct FileView {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    static FileView of(const std::vector<char>& buffer) {
+        return { buffer.data(), buffer.size() };
+    }
+
+    // FNV-1a 64 bits, identifies contents across sessions
+    uint64_t getHash() const {
+        return getHash(0xcbf29ce484222325ull);
+    }
+
+    // Continue the hash of the views before
+    uint64_t getHash(uint64_t hash) const {
+        for (size_t i=0; i<size; i++) {
+            hash ^= (unsigned char) data[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+};
@@ -1,7 +1,6 @@
 #include "localfile.h"
 
 #include <fstream>
-#include <memory>
 
 LocalFile::LocalFile(const std::filesystem::path path) :
     File(path) {
@@ -19,21 +18,28 @@ bool LocalFile::getAsBuffer(std::vector<char>& buffer) {
     }
 
     const auto fileSize = ifs.tellg();
-    const auto readBuffer = std::unique_ptr<char[]>(new char[fileSize]);
 
+    // Straight into the caller buffer
+    buffer.resize(fileSize);
     ifs.seekg(0, std::ios::beg);
-    if (!ifs.read(readBuffer.get(), fileSize)) {
+    if (!ifs.read(buffer.data(), fileSize)) {
         ifs.close();
+        buffer.clear();
 
         mError = mPath;
         return false;
     }
-
-    // Ensure empty buffer
-    buffer.clear();
-    buffer.reserve(fileSize);
-    buffer.insert(buffer.begin(), readBuffer.get(), readBuffer.get() + fileSize);
     ifs.close();
 
     return true;
 }
+
+std::shared_ptr<FileContent> LocalFile::readContent() {
+    const auto content = std::make_shared<FileContent>();
+    if (!content->map(mPath)) {
+        mError = content->getError();
+        return nullptr;
+    }
+
+    return content;
+}
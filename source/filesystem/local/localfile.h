@@ -13,6 +13,9 @@ class LocalFile : public File {
 
         virtual bool getAsBuffer(std::vector<char>& buffer) override;
 
+    protected:
+        virtual std::shared_ptr<FileContent> readContent() override;
+
     private:
         LocalFile(const LocalFile& copy);
 
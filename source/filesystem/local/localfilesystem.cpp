@@ -49,7 +49,8 @@ bool LocalFileSystem::navigate(const std::string path, std::vector<Entry>& list)
                 list.push_back((FileSystem::Entry) {
                     .folder = p.is_directory(),
                     .name = filename,
-                    .size = p.is_directory() ? 0 : p.file_size()
+                    .size = p.is_directory() ? 0 : p.file_size(),
+                    .modified = (int64_t) p.last_write_time(errorCode).time_since_epoch().count()
                 });
             }
         }
@@ -0,0 +1,272 @@
+#include "unpacker.h"
+
+#include <cstring>
+#include <zlib.h>
+
+const size_t Unpacker::MAX_UNPACKED_SIZE = 64 * 1024 * 1024;
+const size_t Unpacker::CACHE_SIZE = 8 * 1024 * 1024;
+
+static const size_t GZIP_HEADER_SIZE = 18;
+static const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+static const size_t ZIP_END_OF_DIRECTORY_SIZE = 22;
+static const size_t ZIP_MAX_COMMENT_SIZE = 0xffff;
+static const Uint16 ZIP_FLAG_ENCRYPTED = 1;
+static const Uint16 ZIP_FLAG_DATA_DESCRIPTOR = 8;
+static const size_t ICE_HEADER_SIZE = 12;
+
+// Bits, all ones value and added count of the literal run lengths, longest last
+static const int ICE_RUN_BITS[] = { 15, 8, 3, 2, 2 };
+static const int ICE_RUN_MAX[] = { 0x7fff, 0xff, 0x07, 0x03, 0x03 };
+static const int ICE_RUN_BASE[] = { 269, 14, 7, 4, 1 };
+// Bits and base of the string lengths and offsets, by prefix length
+static const int ICE_LENGTH_BITS[] = { 10, 2, 1, 0, 0 };
+static const int ICE_LENGTH_BASE[] = { 8, 4, 2, 1, 0 };
+static const int ICE_OFFSET_BITS[] = { 12, 5, 8 };
+static const int ICE_OFFSET_BASE[] = { 0x11f, -1, 0x1f };
+
+Unpacker::Unpacker() :
+    mCacheMutex(SDL_CreateMutex()),
+    mCacheSize(0) {
+}
+
+Unpacker::~Unpacker() {
+    if (mCacheMutex != nullptr) {
+        SDL_DestroyMutex(mCacheMutex);
+        mCacheMutex = nullptr;
+    }
+}
+
+std::shared_ptr<FileContent> Unpacker::unpack(const std::shared_ptr<FileContent> content) {
+    const auto view = content->getView();
+    const auto data = (const Uint8*) view.data;
+    const auto isGzip = view.size >= GZIP_HEADER_SIZE && data[0] == 0x1f && data[1] == 0x8b && data[2] == Z_DEFLATED;
+    const auto isZip = view.size >= ZIP_LOCAL_HEADER_SIZE && std::memcmp(data, "PK\x03\x04", 4) == 0;
+    const auto isIce = view.size > ICE_HEADER_SIZE && std::memcmp(data, "ICE!", 4) == 0;
+    if (!isGzip && !isZip && !isIce) {
+        return content;
+    }
+
+    // Packed files are small, hashing them is cheap next to unpacking
+    const auto hash = view.getHash();
+    SDL_LockMutex(mCacheMutex);
+    for (auto cached = mCache.begin(); cached != mCache.end(); cached++) {
+        if (cached->first == hash) {
+            mCache.splice(mCache.begin(), mCache, cached);
+            const auto unpacked = cached->second;
+            SDL_UnlockMutex(mCacheMutex);
+            return unpacked;
+        }
+    }
+    SDL_UnlockMutex(mCacheMutex);
+
+    // Decoders may still handle the packed content, like sc68 does for ICE!
+    std::vector<char> buffer;
+    if (!(isGzip ? unpackGzip(view, buffer) : isZip ? unpackZip(view, buffer) : unpackIce(view, buffer))) {
+        return content;
+    }
+
+    const auto size = buffer.size();
+    const auto unpacked = std::make_shared<FileContent>();
+    unpacked->assign(std::move(buffer));
+    if (size <= CACHE_SIZE) {
+        SDL_LockMutex(mCacheMutex);
+        mCache.emplace_front(hash, unpacked);
+        mCacheSize += size;
+        while (mCacheSize > CACHE_SIZE) {
+            mCacheSize -= mCache.back().second->getView().size;
+            mCache.pop_back();
+        }
+        SDL_UnlockMutex(mCacheMutex);
+    }
+
+    return unpacked;
+}
+
+bool Unpacker::unpackGzip(const FileView packed, std::vector<char>& buffer) {
+    // The unpacked size modulo 4 GB ends the file
+    const auto trailer = (const Uint8*) packed.data + packed.size - 4;
+    const auto size = (size_t) (trailer[0] | trailer[1] << 8 | trailer[2] << 16 | (Uint32) trailer[3] << 24);
+    if (size == 0 || size > MAX_UNPACKED_SIZE) {
+        return false;
+    }
+
+    buffer.resize(size);
+    return inflateRaw(packed, 16 + MAX_WBITS, buffer);
+}
+
+bool Unpacker::unpackZip(const FileView packed, std::vector<char>& buffer) {
+    const auto header = (const Uint8*) packed.data;
+    const auto read16 = [header](const size_t offset) {
+        return (Uint16) (header[offset] | header[offset + 1] << 8);
+    };
+    const auto read32 = [header](const size_t offset) {
+        return (Uint32) (header[offset] | header[offset + 1] << 8 | header[offset + 2] << 16 | (Uint32) header[offset + 3] << 24);
+    };
+
+    // Only a zip holding a single song is one, an archive of several is left to browse.
+    // The end record is last, followed by a comment of unknown size.
+    if (packed.size < ZIP_LOCAL_HEADER_SIZE + ZIP_END_OF_DIRECTORY_SIZE) {
+        return false;
+    }
+    const auto lastEnd = packed.size - ZIP_END_OF_DIRECTORY_SIZE;
+    const auto firstEnd = lastEnd > ZIP_MAX_COMMENT_SIZE ? lastEnd - ZIP_MAX_COMMENT_SIZE : 0;
+    auto end = lastEnd + 1;
+    for (auto position = lastEnd + 1; position > firstEnd && end > lastEnd; position--) {
+        if (std::memcmp(header + position - 1, "PK\x05\x06", 4) == 0) {
+            end = position - 1;
+        }
+    }
+    if (end > lastEnd || read16(end + 8) != 1 || read16(end + 10) != 1) {
+        return false;
+    }
+
+    // The sizes of that member must be known before its data
+
+    const auto flags = read16(6);
+    const auto method = read16(8);
+    const auto compressedSize = read32(18);
+    const auto size = read32(22);
+    const auto dataOffset = ZIP_LOCAL_HEADER_SIZE + read16(26) + read16(28);
+    if ((flags & (ZIP_FLAG_ENCRYPTED | ZIP_FLAG_DATA_DESCRIPTOR)) != 0 || size == 0 || size > MAX_UNPACKED_SIZE ||
+        dataOffset + compressedSize > packed.size) {
+
+        return false;
+    }
+
+    const auto data = FileView{ packed.data + dataOffset, compressedSize };
+    buffer.resize(size);
+    if (method == Z_DEFLATED) {
+        if (!inflateRaw(data, -MAX_WBITS, buffer)) {
+            return false;
+        }
+    } else if (method == 0 && compressedSize == size) {
+        std::memcpy(buffer.data(), data.data, size);
+    } else {
+        return false;
+    }
+
+    return crc32(0, (const Bytef*) buffer.data(), buffer.size()) == read32(14);
+}
+
+bool Unpacker::unpackIce(const FileView packed, std::vector<char>& buffer) {
+    const auto data = (const Uint8*) packed.data;
+    const auto packedSize = (size_t) ((Uint32) data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7]);
+    const auto size = (size_t) ((Uint32) data[8] << 24 | data[9] << 16 | data[10] << 8 | data[11]);
+    if (packedSize <= ICE_HEADER_SIZE || packedSize > packed.size || size == 0 || size > MAX_UNPACKED_SIZE) {
+        return false;
+    }
+
+    // Both the packed data and the result are walked from their end
+    auto source = packedSize;
+    auto damaged = false;
+    const auto readByte = [&]() -> Uint8 {
+        if (source <= ICE_HEADER_SIZE) {
+            damaged = true;
+            return 0;
+        }
+        return data[--source];
+    };
+
+    // Bits come from the highest, a last set bit marks when to read a new byte
+    auto bits = readByte();
+    const auto readBit = [&]() -> int {
+        const auto bit = bits >> 7;
+        bits <<= 1;
+        if (bits != 0) {
+            return bit;
+        }
+
+        const auto next = readByte();
+        bits = (Uint8) (next << 1 | bit);
+        return next >> 7;
+    };
+    const auto readBits = [&](const int count) {
+        auto value = 0;
+        for (auto i=0; i<count; i++) {
+            value = value << 1 | readBit();
+        }
+        return value;
+    };
+
+    buffer.resize(size);
+    auto output = size;
+    while (!damaged) {
+        // Literal bytes, if any
+        if (readBit() == 1) {
+            auto count = 1;
+            if (readBit() == 1) {
+                for (auto i=4; i>=0; i--) {
+                    const auto value = readBits(ICE_RUN_BITS[i]);
+                    if (value != ICE_RUN_MAX[i] || i == 0) {
+                        count = value + ICE_RUN_BASE[i] + 1;
+                        break;
+                    }
+                }
+            }
+
+            if ((size_t) count > output) {
+                return false;
+            }
+            for (auto i=0; i<count; i++) {
+                buffer[--output] = readByte();
+            }
+        }
+
+        if (output == 0) {
+            break;
+        }
+
+        // Then a string already unpacked, given by a prefix of up to four set bits
+        auto prefix = 0;
+        while (prefix < 4 && readBit() == 1) {
+            prefix++;
+        }
+        const auto lengthIndex = 4 - prefix;
+        const auto length = ICE_LENGTH_BASE[lengthIndex] + readBits(ICE_LENGTH_BITS[lengthIndex]);
+
+        auto offset = 0;
+        if (length == 0) {
+            offset = readBit() == 1 ? readBits(9) + 0x3f : readBits(6) - 1;
+        } else {
+            auto offsetPrefix = 0;
+            while (offsetPrefix < 2 && readBit() == 1) {
+                offsetPrefix++;
+            }
+            const auto offsetIndex = 2 - offsetPrefix;
+            offset = readBits(ICE_OFFSET_BITS[offsetIndex]) + ICE_OFFSET_BASE[offsetIndex];
+            if (offset < 0) {
+                offset -= length;
+            }
+        }
+
+        const auto count = (size_t) length + 2;
+        const auto from = (long) output + (long) count + offset;
+        if (count > output || from > (long) size || from - (long) count < 0) {
+            return false;
+        }
+        for (size_t i=1; i<=count; i++) {
+            buffer[output - i] = buffer[from - i];
+        }
+        output -= count;
+    }
+
+    // The picture filter of Pack-Ice follows, songs do not use it
+    return !damaged;
+}
+
+bool Unpacker::inflateRaw(const FileView packed, const int windowBits, std::vector<char>& buffer) {
+    z_stream stream = {};
+    if (inflateInit2(&stream, windowBits) != Z_OK) {
+        return false;
+    }
+
+    stream.next_in = (Bytef*) packed.data;
+    stream.avail_in = packed.size;
+    stream.next_out = (Bytef*) buffer.data();
+    stream.avail_out = buffer.size();
+    const auto result = inflate(&stream, Z_FINISH);
+    const auto inflated = stream.total_out;
+    inflateEnd(&stream);
+
+    return result == Z_STREAM_END && inflated == buffer.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "filecontent.h"
+
+#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_stdinc.h>
+
+// Unpack songs stored packed, found from their first bytes: gzip, ICE! as used
+// by many Atari SNDH files, and zip files holding a single song like modland
+// MDZ. Unpacked songs are kept by hash of their packed content, playing them
+// again or reading their informations does not unpack them again.
+class Unpacker {
+
+    public:
+        // Far above any song, protects from damaged sizes in headers
+        static const size_t MAX_UNPACKED_SIZE;
+
+        Unpacker();
+        virtual ~Unpacker();
+
+        // The content itself when not packed or not unpackable
+        std::shared_ptr<FileContent> unpack(const std::shared_ptr<FileContent> content);
+
+    private:
+        static const size_t CACHE_SIZE;
+
+        SDL_mutex* mCacheMutex;
+        // Most recently used first
+        std::list<std::pair<uint64_t, std::shared_ptr<FileContent>>> mCache;
+        size_t mCacheSize;
+
+        Unpacker(const Unpacker& copy);
+
+        static bool unpackGzip(const FileView packed, std::vector<char>& buffer);
+        static bool unpackZip(const FileView packed, std::vector<char>& buffer);
+        static bool unpackIce(const FileView packed, std::vector<char>& buffer);
+        static bool inflateRaw(const FileView packed, const int windowBits, std::vector<char>& buffer);
+
+};
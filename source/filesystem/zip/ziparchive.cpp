@@ -0,0 +1,327 @@
+#include "ziparchive.h"
+
+#include "../unpacker.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+// Songs are small, big modules are read again
+const size_t ZipArchive::MAX_CACHED_MEMBER_SIZE = 1024 * 1024;
+const size_t ZipArchive::MEMBER_CACHE_SIZE = 4 * 1024 * 1024;
+const size_t ZipArchive::READ_CHUNK_SIZE = 64 * 1024;
+
+// Record signatures and fixed sizes from the zip specification
+static const Uint32 END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+static const Uint32 DIRECTORY_ENTRY_SIGNATURE = 0x02014b50;
+static const Uint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const size_t END_OF_DIRECTORY_SIZE = 22;
+static const size_t DIRECTORY_ENTRY_SIZE = 46;
+static const size_t LOCAL_HEADER_SIZE = 30;
+static const size_t MAX_COMMENT_SIZE = 0xffff;
+static const Uint16 METHOD_STORED = 0;
+static const Uint16 METHOD_DEFLATED = 8;
+static const Uint16 FLAG_ENCRYPTED = 1;
+
+ZipArchive::ZipArchive(const std::filesystem::path path) :
+    mPath(path),
+    mSize(0),
+    mModified(0),
+    mCacheMutex(SDL_CreateMutex()),
+    mCacheSize(0) {
+}
+
+ZipArchive::~ZipArchive() {
+    if (mCacheMutex != nullptr) {
+        SDL_DestroyMutex(mCacheMutex);
+        mCacheMutex = nullptr;
+    }
+}
+
+bool ZipArchive::open() {
+    std::error_code errorCode;
+    mSize = std::filesystem::file_size(mPath, errorCode);
+    mModified = (int64_t) std::filesystem::last_write_time(mPath, errorCode).time_since_epoch().count();
+
+    std::ifstream is(mPath.c_str(), std::ios::in | std::ios::binary);
+    if (errorCode || !is.good() || !readDirectory(is)) {
+        mError = mPath;
+        return false;
+    }
+
+    return true;
+}
+
+std::filesystem::path ZipArchive::getPath() const {
+    return mPath;
+}
+
+uintmax_t ZipArchive::getSize() const {
+    return mSize;
+}
+
+int64_t ZipArchive::getModified() const {
+    return mModified;
+}
+
+bool ZipArchive::navigate(const std::string folder, std::vector<FileSystem::Entry>& list) const {
+    const auto found = mFolders.find(folder);
+    if (found == mFolders.end()) {
+        return false;
+    }
+
+    list.clear();
+    list.reserve(found->second.first.size() + found->second.second.size());
+    for (const auto& name : found->second.first) {
+        list.push_back({
+            .folder = true,
+            .name = name,
+            .size = 0
+        });
+    }
+    for (const auto index : found->second.second) {
+        const auto& member = mMembers[index];
+        list.push_back({
+            .folder = false,
+            .name = member.name.substr(member.name.rfind('/') + 1),
+            .size = member.size,
+            .modified = member.modified
+        });
+    }
+
+    return true;
+}
+
+std::shared_ptr<FileContent> ZipArchive::getContent(const std::string name) {
+    const auto found = mMemberIndexes.find(name);
+    if (found == mMemberIndexes.end()) {
+        return nullptr;
+    }
+
+    const auto index = found->second;
+    SDL_LockMutex(mCacheMutex);
+    for (auto cached = mCache.begin(); cached != mCache.end(); cached++) {
+        if (cached->first == index) {
+            mCache.splice(mCache.begin(), mCache, cached);
+            const auto content = cached->second;
+            SDL_UnlockMutex(mCacheMutex);
+            return content;
+        }
+    }
+    SDL_UnlockMutex(mCacheMutex);
+
+    // Inflated without holding the cache, the indexer may read meanwhile
+    const auto& member = mMembers[index];
+    std::vector<char> buffer;
+    if (!readMember(member, buffer)) {
+        return nullptr;
+    }
+
+    const auto content = std::make_shared<FileContent>();
+    content->assign(std::move(buffer));
+    if (member.size <= MAX_CACHED_MEMBER_SIZE) {
+        SDL_LockMutex(mCacheMutex);
+        mCache.emplace_front(index, content);
+        mCacheSize += member.size;
+        while (mCacheSize > MEMBER_CACHE_SIZE) {
+            mCacheSize -= mMembers[mCache.back().first].size;
+            mCache.pop_back();
+        }
+        SDL_UnlockMutex(mCacheMutex);
+    }
+
+    return content;
+}
+
+std::string ZipArchive::getError() const {
+    return mError;
+}
+
+bool ZipArchive::readDirectory(std::ifstream& is) {
+    // The end record is last, followed by a comment of unknown size
+    const auto tailSize = (size_t) std::min<uintmax_t>(mSize, END_OF_DIRECTORY_SIZE + MAX_COMMENT_SIZE);
+    if (tailSize < END_OF_DIRECTORY_SIZE) {
+        return false;
+    }
+
+    std::vector<char> tail(tailSize);
+    is.seekg(mSize - tailSize, std::ios::beg);
+    if (!is.read(tail.data(), tailSize)) {
+        return false;
+    }
+
+    const char* end = nullptr;
+    for (auto position = tailSize - END_OF_DIRECTORY_SIZE + 1; position > 0 && end == nullptr; position--) {
+        if (read32(tail.data() + position - 1) == END_OF_DIRECTORY_SIGNATURE) {
+            end = tail.data() + position - 1;
+        }
+    }
+
+    // Zip64 archives are not supported, their sizes are saturated here
+    if (end == nullptr) {
+        return false;
+    }
+    const auto memberCount = read16(end + 10);
+    const auto directorySize = read32(end + 12);
+    const auto directoryOffset = read32(end + 16);
+    if (memberCount == 0xffff || directoryOffset == 0xffffffff || (uintmax_t) directoryOffset + directorySize > mSize) {
+        return false;
+    }
+
+    // One read for the whole directory, then parsed in memory
+    std::vector<char> directory(directorySize);
+    is.seekg(directoryOffset, std::ios::beg);
+    if (!is.read(directory.data(), directorySize)) {
+        return false;
+    }
+
+    mMembers.clear();
+    mMemberIndexes.clear();
+    mFolders.clear();
+    mMembers.reserve(memberCount);
+    getFolder("");
+
+    for (size_t position=0; position + DIRECTORY_ENTRY_SIZE <= directory.size();) {
+        const auto entry = directory.data() + position;
+        if (read32(entry) != DIRECTORY_ENTRY_SIGNATURE) {
+            return false;
+        }
+
+        const auto nameSize = read16(entry + 28);
+        const auto next = position + DIRECTORY_ENTRY_SIZE + nameSize + read16(entry + 30) + read16(entry + 32);
+        if (next > directory.size()) {
+            return false;
+        }
+
+        Member member = {
+            .name = std::string(entry + DIRECTORY_ENTRY_SIZE, nameSize),
+            .method = read16(entry + 10),
+            .crc = read32(entry + 16),
+            .compressedSize = read32(entry + 20),
+            .size = read32(entry + 24),
+            .localHeaderOffset = read32(entry + 42),
+            // DOS date and time
+            .modified = (int64_t) read16(entry + 14) << 16 | read16(entry + 12)
+        };
+
+        // Only what can be read back is listed
+        if ((read16(entry + 8) & FLAG_ENCRYPTED) == 0 &&
+            (member.method == METHOD_STORED || member.method == METHOD_DEFLATED)) {
+
+            addMember(member);
+        }
+        position = next;
+    }
+
+    return true;
+}
+
+void ZipArchive::addMember(Member& member) {
+    std::replace(member.name.begin(), member.name.end(), '\\', '/');
+    member.name.erase(0, member.name.find_first_not_of('/'));
+
+    // Hidden the same way as on the local file system, with resource forks
+    for (size_t start=0; start<member.name.size();) {
+        const auto slash = member.name.find('/', start);
+        const auto part = member.name.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+        if (part.empty() || part[0] == '.' || part == "__MACOSX") {
+            break;
+        }
+
+        if (slash == std::string::npos) {
+            // A file, in the folder before it
+            if (mMemberIndexes.emplace(member.name, (Uint32) mMembers.size()).second) {
+                getFolder(start > 0 ? member.name.substr(0, start - 1) : "").second.push_back(mMembers.size());
+                mMembers.push_back(member);
+            }
+            break;
+        }
+
+        // Folders only have their own entry in some archives
+        getFolder(member.name.substr(0, slash));
+        start = slash + 1;
+    }
+}
+
+std::pair<std::vector<std::string>, std::vector<Uint32>>& ZipArchive::getFolder(const std::string path) {
+    if (const auto found = mFolders.find(path); found != mFolders.end()) {
+        return found->second;
+    }
+
+    if (!path.empty()) {
+        const auto slash = path.rfind('/');
+        getFolder(slash == std::string::npos ? "" : path.substr(0, slash)).first.push_back(
+            path.substr(slash == std::string::npos ? 0 : slash + 1));
+    }
+
+    return mFolders[path];
+}
+
+bool ZipArchive::readMember(const Member& member, std::vector<char>& buffer) const {
+    std::ifstream is(mPath.c_str(), std::ios::in | std::ios::binary);
+    char header[LOCAL_HEADER_SIZE];
+    is.seekg(member.localHeaderOffset, std::ios::beg);
+    if (!is.read(header, LOCAL_HEADER_SIZE) || read32(header) != LOCAL_HEADER_SIGNATURE) {
+        return false;
+    }
+
+    // The local extra field may differ from the directory one. Damaged sizes would
+    // allocate far more than any song or read past the archive.
+    const auto dataOffset = (uintmax_t) member.localHeaderOffset + LOCAL_HEADER_SIZE + read16(header + 26) + read16(header + 28);
+    if (member.size > Unpacker::MAX_UNPACKED_SIZE || dataOffset + member.compressedSize > mSize) {
+        return false;
+    }
+    is.seekg(dataOffset, std::ios::beg);
+    buffer.resize(member.size);
+
+    // Nothing to inflate into, zlib would refuse it
+    if (member.size == 0) {
+        return member.crc == 0;
+    }
+
+    if (member.method == METHOD_STORED) {
+        if (member.compressedSize != member.size || !is.read(buffer.data(), member.size)) {
+            return false;
+        }
+    } else {
+        z_stream stream = {};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return false;
+        }
+
+        // Compressed data streamed by chunks, inflated in place into the result
+        std::vector<char> chunk(std::min<size_t>(READ_CHUNK_SIZE, member.compressedSize));
+        stream.next_out = (Bytef*) buffer.data();
+        stream.avail_out = member.size;
+        auto remaining = (size_t) member.compressedSize;
+        auto result = Z_OK;
+        while (result == Z_OK && remaining > 0) {
+            const auto chunkSize = std::min(remaining, chunk.size());
+            if (!is.read(chunk.data(), chunkSize)) {
+                break;
+            }
+            remaining -= chunkSize;
+
+            stream.next_in = (Bytef*) chunk.data();
+            stream.avail_in = chunkSize;
+            result = inflate(&stream, Z_NO_FLUSH);
+        }
+
+        const auto inflated = stream.total_out;
+        inflateEnd(&stream);
+        if (result != Z_STREAM_END || inflated != member.size) {
+            return false;
+        }
+    }
+
+    return crc32(0, (const Bytef*) buffer.data(), buffer.size()) == member.crc;
+}
+
+Uint16 ZipArchive::read16(const char* data) {
+    const auto bytes = (const Uint8*) data;
+    return bytes[0] | bytes[1] << 8;
+}
+
+Uint32 ZipArchive::read32(const char* data) {
+    const auto bytes = (const Uint8*) data;
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (Uint32) bytes[3] << 24;
+}
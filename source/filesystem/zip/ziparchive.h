@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../filecontent.h"
+#include "../filesystem.h"
+
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_stdinc.h>
+
+// Central directory of a zip file, read once and kept with a folder index so
+// listing any folder of a big archive only walks its own entries. Members are
+// inflated straight from the file into their final buffer, the small ones
+// recently read stay in memory for the next reads.
+class ZipArchive {
+
+    public:
+        ZipArchive(const std::filesystem::path path);
+        virtual ~ZipArchive();
+
+        bool open();
+
+        std::filesystem::path getPath() const;
+        // Identify the archive file version the directory was read from
+        uintmax_t getSize() const;
+        int64_t getModified() const;
+
+        // Path inside the archive, without leading or trailing slash
+        bool navigate(const std::string folder, std::vector<FileSystem::Entry>& list) const;
+        std::shared_ptr<FileContent> getContent(const std::string name);
+
+        std::string getError() const;
+
+    private:
+        struct Member {
+            std::string name;
+            Uint16 method;
+            Uint32 crc;
+            Uint32 compressedSize;
+            Uint32 size;
+            Uint32 localHeaderOffset;
+            int64_t modified;
+        };
+
+        static const size_t MAX_CACHED_MEMBER_SIZE;
+        static const size_t MEMBER_CACHE_SIZE;
+        static const size_t READ_CHUNK_SIZE;
+
+        const std::filesystem::path mPath;
+        uintmax_t mSize;
+        int64_t mModified;
+
+        std::vector<Member> mMembers;
+        std::unordered_map<std::string, Uint32> mMemberIndexes;
+        // Folder path to the sub folder names and member indexes it holds
+        std::unordered_map<std::string, std::pair<std::vector<std::string>, std::vector<Uint32>>> mFolders;
+
+        SDL_mutex* mCacheMutex;
+        std::list<std::pair<Uint32, std::shared_ptr<FileContent>>> mCache;
+        size_t mCacheSize;
+        std::string mError;
+
+        ZipArchive(const ZipArchive& copy);
+
+        bool readDirectory(std::ifstream& is);
+        void addMember(Member& member);
+        std::pair<std::vector<std::string>, std::vector<Uint32>>& getFolder(const std::string path);
+        bool readMember(const Member& member, std::vector<char>& buffer) const;
+
+        static Uint16 read16(const char* data);
+        static Uint32 read32(const char* data);
+
+};
@@ -0,0 +1,31 @@
+#include "zipfile.h"
+
+ZipFile::ZipFile(const std::filesystem::path path, const std::shared_ptr<ZipArchive> archive, const std::string name) :
+    File(path),
+    mArchive(archive),
+    mName(name) {
+}
+
+ZipFile::~ZipFile() {
+}
+
+bool ZipFile::getAsBuffer(std::vector<char>& buffer) {
+    const auto content = readContent();
+    if (content == nullptr) {
+        return false;
+    }
+
+    const auto view = content->getView();
+    buffer.assign(view.data, view.data + view.size);
+    return true;
+}
+
+std::shared_ptr<FileContent> ZipFile::readContent() {
+    // Shared with the archive cache, it is never modified
+    const auto content = mArchive != nullptr ? mArchive->getContent(mName) : nullptr;
+    if (content == nullptr) {
+        mError = mPath;
+    }
+
+    return content;
+}
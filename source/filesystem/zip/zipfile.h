@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../file.h"
+#include "ziparchive.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ZipFile : public File {
+
+    public:
+        // Name is the member path inside the archive
+        ZipFile(const std::filesystem::path path, const std::shared_ptr<ZipArchive> archive, const std::string name);
+        virtual ~ZipFile();
+
+        virtual bool getAsBuffer(std::vector<char>& buffer) override;
+
+    protected:
+        virtual std::shared_ptr<FileContent> readContent() override;
+
+    private:
+        const std::shared_ptr<ZipArchive> mArchive;
+        const std::string mName;
+
+        ZipFile(const ZipFile& copy);
+
+};
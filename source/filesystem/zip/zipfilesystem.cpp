@@ -0,0 +1,146 @@
+#include "zipfilesystem.h"
+
+#include "zipfile.h"
+
+#include <algorithm>
+#include <cctype>
+
+// HVSC and a few modland packs browsed at the same time
+const size_t ZipFileSystem::MAX_ARCHIVES = 4;
+
+ZipFileSystem::ZipFileSystem(const std::shared_ptr<FileSystem> fileSystem) :
+    FileSystem(),
+    mFileSystem(fileSystem),
+    mArchivesMutex(SDL_CreateMutex()) {
+}
+
+ZipFileSystem::~ZipFileSystem() {
+    if (mArchivesMutex != nullptr) {
+        SDL_DestroyMutex(mArchivesMutex);
+        mArchivesMutex = nullptr;
+    }
+}
+
+bool ZipFileSystem::setup() {
+    if (!mFileSystem->setup()) {
+        mError = mFileSystem->getError();
+        return false;
+    }
+
+    return true;
+}
+
+void ZipFileSystem::cleanup() {
+    SDL_LockMutex(mArchivesMutex);
+    mArchives.clear();
+    SDL_UnlockMutex(mArchivesMutex);
+
+    mFileSystem->cleanup();
+}
+
+std::string ZipFileSystem::getMountPoint() const {
+    return mFileSystem->getMountPoint();
+}
+
+bool ZipFileSystem::navigate(const std::string path, std::vector<Entry>& list) {
+    std::filesystem::path archivePath;
+    std::string name;
+    if (splitPath(path, archivePath, name)) {
+        const auto archive = getArchive(archivePath);
+        if (archive == nullptr || !archive->navigate(name, list)) {
+            mError = path;
+            return false;
+        }
+
+        return true;
+    }
+
+    if (!mFileSystem->navigate(path, list)) {
+        mError = mFileSystem->getError();
+        return false;
+    }
+
+    for (auto& entry : list) {
+        if (!entry.folder && isArchive(entry.name)) {
+            entry.folder = true;
+        }
+    }
+
+    return true;
+}
+
+std::shared_ptr<File> ZipFileSystem::getFile(const std::string path) const {
+    std::filesystem::path archivePath;
+    std::string name;
+    if (splitPath(path, archivePath, name)) {
+        return std::shared_ptr<File>(new ZipFile(path, getArchive(archivePath), name));
+    }
+
+    return mFileSystem->getFile(path);
+}
+
+std::shared_ptr<ZipArchive> ZipFileSystem::getArchive(const std::filesystem::path path) const {
+    std::error_code errorCode;
+    const auto size = std::filesystem::file_size(path, errorCode);
+    const auto modified = (int64_t) std::filesystem::last_write_time(path, errorCode).time_since_epoch().count();
+
+    // Held while reading a directory, the other thread would read it too
+    SDL_LockMutex(mArchivesMutex);
+    for (auto archive = mArchives.begin(); archive != mArchives.end(); archive++) {
+        if ((*archive)->getPath() == path) {
+            if ((*archive)->getSize() == size && (*archive)->getModified() == modified) {
+                mArchives.splice(mArchives.begin(), mArchives, archive);
+                const auto found = *archive;
+                SDL_UnlockMutex(mArchivesMutex);
+                return found;
+            }
+
+            // Replaced since, read again
+            mArchives.erase(archive);
+            break;
+        }
+    }
+
+    const auto archive = std::make_shared<ZipArchive>(path);
+    if (errorCode || !archive->open()) {
+        SDL_UnlockMutex(mArchivesMutex);
+        return nullptr;
+    }
+
+    mArchives.push_front(archive);
+    if (mArchives.size() > MAX_ARCHIVES) {
+        mArchives.pop_back();
+    }
+    SDL_UnlockMutex(mArchivesMutex);
+
+    return archive;
+}
+
+bool ZipFileSystem::isArchive(const std::filesystem::path path) {
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    return extension == ".zip";
+}
+
+bool ZipFileSystem::splitPath(const std::string path, std::filesystem::path& archivePath, std::string& name) {
+    // The first zip file met, archives inside archives are not opened
+    const auto fullPath = std::filesystem::path(path);
+    std::filesystem::path prefix;
+    for (auto part = fullPath.begin(); part != fullPath.end(); part++) {
+        prefix /= *part;
+        std::error_code errorCode;
+        if (isArchive(*part) && std::filesystem::is_regular_file(prefix, errorCode)) {
+            archivePath = prefix;
+            name.clear();
+            for (part++; part != fullPath.end(); part++) {
+                if (!part->empty()) {
+                    name.append(name.empty() ? "" : "/").append(part->string());
+                }
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
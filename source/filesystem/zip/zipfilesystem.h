@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../file.h"
+#include "../filesystem.h"
+#include "ziparchive.h"
+
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SDL2/SDL_mutex.h>
+
+// Show the zip files of another file system as folders and read their songs
+// without extracting them. The directories of the last archives opened are
+// kept, going back into one of them costs nothing.
+class ZipFileSystem : public FileSystem {
+
+    public:
+        ZipFileSystem(const std::shared_ptr<FileSystem> fileSystem);
+        virtual ~ZipFileSystem();
+
+        virtual bool setup() override;
+        virtual void cleanup() override;
+
+        virtual std::string getMountPoint() const override;
+        virtual bool navigate(const std::string path, std::vector<Entry>& list) override;
+        virtual std::shared_ptr<File> getFile(const std::string path) const override;
+
+    private:
+        static const size_t MAX_ARCHIVES;
+
+        const std::shared_ptr<FileSystem> mFileSystem;
+
+        // Most recently used first, shared by the browser and the indexer threads
+        mutable std::list<std::shared_ptr<ZipArchive>> mArchives;
+        SDL_mutex* mArchivesMutex;
+
+        ZipFileSystem(const ZipFileSystem& copy);
+
+        std::shared_ptr<ZipArchive> getArchive(const std::filesystem::path path) const;
+
+        static bool isArchive(const std::filesystem::path path);
+        // False if path is not inside an archive
+        static bool splitPath(const std::string path, std::filesystem::path& archivePath, std::string& name);
+
+};
@@ -0,0 +1,543 @@
+#include "libraryindexer.h"
+
+#include "decoder/decoderfactory.h"
+#include "searchindex.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <SDL2/SDL_log.h>
+#include <SDL2/SDL_timer.h>
+
+// Older indexes are dropped and rebuilt
+const int LibraryIndexer::INDEX_VERSION = 2;
+// Symbolic links can make a folder its own child
+const int LibraryIndexer::MAX_DEPTH = 32;
+// A long first scan is published and saved as it goes
+const Uint32 LibraryIndexer::CHECKPOINT_INTERVAL = 30000;
+const size_t LibraryIndexer::CHECKPOINT_RECORDS = 1000;
+
+LibraryIndexer::LibraryIndexer() :
+    mRecords(std::make_shared<const std::vector<Record>>()),
+    mGeneration(0),
+    mSearchThread(nullptr),
+    mSearchMutex(SDL_CreateMutex()),
+    mSearchCond(SDL_CreateCond()),
+    mMaxSearchResults(0),
+    mSearchRequested(false),
+    mSearchResults(std::make_shared<const std::vector<Record>>()),
+    mSearchGeneration(0),
+    mThread(nullptr),
+    mScanMutex(SDL_CreateMutex()),
+    mScanCond(SDL_CreateCond()),
+    mRunning(false),
+    mScanning(false),
+    mFresh(false),
+    mScanRequested(false),
+    mLifecycleMutex(nullptr) {
+}
+
+LibraryIndexer::~LibraryIndexer() {
+    cleanup();
+
+    if (mScanMutex != nullptr) {
+        SDL_DestroyMutex(mScanMutex);
+        mScanMutex = nullptr;
+    }
+
+    if (mScanCond != nullptr) {
+        SDL_DestroyCond(mScanCond);
+        mScanCond = nullptr;
+    }
+
+    if (mSearchMutex != nullptr) {
+        SDL_DestroyMutex(mSearchMutex);
+        mSearchMutex = nullptr;
+    }
+
+    if (mSearchCond != nullptr) {
+        SDL_DestroyCond(mSearchCond);
+        mSearchCond = nullptr;
+    }
+}
+
+bool LibraryIndexer::setup(const std::filesystem::path dataPath, const std::filesystem::path indexPath,
+    const std::vector<std::shared_ptr<FileSystem>>& fileSystemList, std::shared_ptr<Settings> settings,
+    SDL_mutex* lifecycleMutex, const std::function<bool ()>& isBusy) {
+
+    mIndexPath = indexPath;
+    mSearchPath = std::filesystem::path(indexPath).replace_extension(".search");
+    mFileSystemList = fileSystemList;
+    mLifecycleMutex = lifecycleMutex;
+    mIsBusy = isBusy;
+    mSettings = settings;
+    mDecoderList = DecoderFactory(dataPath).createList();
+    mRegistry.setup(mDecoderList);
+
+    // The index is loaded by the thread, then a first scan updates it
+    mRunning = true;
+    mScanRequested = true;
+    if (mThread = SDL_CreateThread(LibraryIndexer::indexerThreadFunc, "OSP-Indexer-Thread", this);
+        mThread == nullptr) {
+
+        mRunning = false;
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unable to start library indexer: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Apart from the scan, a query is not delayed by a folder being read
+    if (mSearchThread = SDL_CreateThread(LibraryIndexer::searchThreadFunc, "OSP-Search-Thread", this);
+        mSearchThread == nullptr) {
+
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unable to start library search: %s\n", SDL_GetError());
+    }
+
+    return true;
+}
+
+void LibraryIndexer::cleanup() {
+    if (mThread != nullptr) {
+        SDL_LockMutex(mScanMutex);
+        mRunning = false;
+        SDL_CondSignal(mScanCond);
+        SDL_UnlockMutex(mScanMutex);
+
+        SDL_WaitThread(mThread, nullptr);
+        mThread = nullptr;
+    }
+
+    if (mSearchThread != nullptr) {
+        SDL_LockMutex(mSearchMutex);
+        SDL_CondSignal(mSearchCond);
+        SDL_UnlockMutex(mSearchMutex);
+
+        SDL_WaitThread(mSearchThread, nullptr);
+        mSearchThread = nullptr;
+    }
+
+    mRegistry.cleanup();
+    if (mLifecycleMutex != nullptr) {
+        SDL_LockMutex(mLifecycleMutex);
+        for (const auto& decoder : mDecoderList) {
+            decoder->cleanup();
+        }
+        SDL_UnlockMutex(mLifecycleMutex);
+    }
+    mDecoderList.clear();
+    mFileSystemList.clear();
+}
+
+void LibraryIndexer::rescan() {
+    if (!mRunning) {
+        return;
+    }
+
+    SDL_LockMutex(mScanMutex);
+    mScanRequested = true;
+    SDL_CondSignal(mScanCond);
+    SDL_UnlockMutex(mScanMutex);
+}
+
+bool LibraryIndexer::isScanning() const {
+    return mScanning;
+}
+
+LibraryIndexer::Records LibraryIndexer::getRecords() const {
+    return std::atomic_load(&mRecords);
+}
+
+Uint32 LibraryIndexer::getGeneration() const {
+    return mGeneration.load(std::memory_order_acquire);
+}
+
+bool LibraryIndexer::navigate(const std::string path, std::vector<FileSystem::Entry>& list) const {
+    // A loaded index may miss what changed while the application was closed
+    if (!mFresh) {
+        return false;
+    }
+
+    const auto records = getRecords();
+    auto prefix = path;
+    if (prefix.empty() || prefix.back() != '/') {
+        prefix.push_back('/');
+    }
+
+    // Sorted by path, everything below the folder is contiguous
+    list.clear();
+    auto record = std::lower_bound(records->begin(), records->end(), prefix, [](const Record& record, const std::string& path) {
+        return record.path < path;
+    });
+    for (; record != records->end() && record->path.compare(0, prefix.size(), prefix) == 0; record++) {
+        const auto name = record->path.substr(prefix.size());
+        if (const auto slash = name.find('/');
+            slash != std::string::npos) {
+
+            if (list.empty() || !list.back().folder || list.back().name != name.substr(0, slash)) {
+                list.push_back({
+                    .folder = true,
+                    .name = name.substr(0, slash),
+                    .size = 0
+                });
+            }
+        } else {
+            list.push_back({
+                .folder = false,
+                .name = name,
+                .size = record->size,
+                .modified = record->modified
+            });
+        }
+    }
+
+    return !list.empty();
+}
+
+void LibraryIndexer::search(const std::string& query, const size_t maxResults) {
+    SDL_LockMutex(mSearchMutex);
+    mSearchQuery = query;
+    mMaxSearchResults = maxResults;
+    mSearchRequested = true;
+    SDL_CondSignal(mSearchCond);
+    SDL_UnlockMutex(mSearchMutex);
+}
+
+LibraryIndexer::Records LibraryIndexer::getSearchResults() const {
+    return std::atomic_load(&mSearchResults);
+}
+
+Uint32 LibraryIndexer::getSearchGeneration() const {
+    return mSearchGeneration.load(std::memory_order_acquire);
+}
+
+void LibraryIndexer::requestSearch() {
+    // Same query again, for the new search index
+    SDL_LockMutex(mSearchMutex);
+    if (!mSearchQuery.empty()) {
+        mSearchRequested = true;
+        SDL_CondSignal(mSearchCond);
+    }
+    SDL_UnlockMutex(mSearchMutex);
+}
+
+void LibraryIndexer::loadIndex() {
+    std::ifstream is(mIndexPath);
+    if (!is.good()) {
+        return;
+    }
+
+    std::string line;
+    if (!std::getline(is, line) || line != std::string("osp-library ").append(std::to_string(INDEX_VERSION))) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Library index: unknown version, rebuilding it.\n");
+        return;
+    }
+
+    // path size modified decoder trackCount duration title author, separated by tabs
+    std::vector<Record> records;
+    while (std::getline(is, line)) {
+        std::istringstream fields(line);
+        std::string size, modified, trackCount, duration;
+        Record record;
+        if (std::getline(fields, record.path, '\t') &&
+            std::getline(fields, size, '\t') &&
+            std::getline(fields, modified, '\t') &&
+            std::getline(fields, record.decoder, '\t') &&
+            std::getline(fields, trackCount, '\t') &&
+            std::getline(fields, duration, '\t') &&
+            std::getline(fields, record.title, '\t') &&
+            std::getline(fields, record.author)) {
+
+            record.size = std::strtoull(size.c_str(), nullptr, 10);
+            record.modified = std::strtoll(modified.c_str(), nullptr, 10);
+            record.trackCount = std::atoi(trackCount.c_str());
+            record.duration = std::atoi(duration.c_str());
+            records.push_back(std::move(record));
+        }
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Library index: %zu songs.\n", records.size());
+    publish(records);
+}
+
+bool LibraryIndexer::saveIndex(const std::vector<Record>& records) const {
+    // Written aside then renamed, an interrupted save keeps the previous index
+    auto tempPath = mIndexPath;
+    tempPath += ".tmp";
+
+    std::ofstream os(tempPath);
+    if (!os.good()) {
+        return false;
+    }
+
+    os << "osp-library " << INDEX_VERSION << "\n";
+    for (const auto& record : records) {
+        os << escape(record.path) << "\t" << record.size << "\t" << record.modified << "\t"
+            << record.decoder << "\t" << record.trackCount << "\t" << record.duration << "\t"
+            << escape(record.title) << "\t" << escape(record.author) << "\n";
+    }
+    os.close();
+
+    std::error_code errorCode;
+    std::filesystem::rename(tempPath, mIndexPath, errorCode);
+    return !os.fail() && !errorCode;
+}
+
+void LibraryIndexer::publish(std::vector<Record>& records) {
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        return a.path < b.path;
+    });
+
+    std::atomic_store(&mRecords, Records(std::make_shared<const std::vector<Record>>(std::move(records))));
+    mGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void LibraryIndexer::publishSearch() {
+    // Only rebuilt when the songs changed since it was saved
+    const auto startTime = SDL_GetTicks();
+    auto searchIndex = std::make_shared<SearchIndex>(getRecords());
+    if (!searchIndex->load(mSearchPath)) {
+        searchIndex->build();
+        if (!searchIndex->save(mSearchPath)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Library index: cannot save %s\n", mSearchPath.c_str());
+        }
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Library index: search index built (%u ms)\n", SDL_GetTicks() - startTime);
+    }
+
+    std::atomic_store(&mSearchIndex, std::shared_ptr<const SearchIndex>(searchIndex));
+    mGeneration.fetch_add(1, std::memory_order_release);
+    requestSearch();
+}
+
+void LibraryIndexer::checkpoint(const std::vector<Record>& records, const std::unordered_map<std::string, const Record*>& known) {
+    // Songs not reached yet are kept as they were
+    std::vector<Record> snapshot;
+    snapshot.reserve(records.size() + known.size());
+    snapshot.insert(snapshot.end(), records.begin(), records.end());
+    for (const auto& record : known) {
+        snapshot.push_back(*record.second);
+    }
+
+    publish(snapshot);
+    if (!saveIndex(*getRecords())) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Library index: cannot save %s\n", mIndexPath.c_str());
+    }
+}
+
+void LibraryIndexer::scan(const std::shared_ptr<FileSystem> fileSystem, std::unordered_map<std::string, const Record*>& known,
+    std::vector<Record>& records) {
+
+    std::vector<std::pair<std::string, int>> folders = { { fileSystem->getMountPoint(), 0 } };
+    std::vector<FileSystem::Entry> list;
+    auto checkpointTime = SDL_GetTicks();
+    size_t opened = 0;
+    while (!folders.empty() && mRunning) {
+        const auto [folder, depth] = folders.back();
+        folders.pop_back();
+
+        if (!fileSystem->navigate(folder, list)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Library index: cannot list %s\n", folder.c_str());
+            continue;
+        }
+
+        for (const auto& entry : list) {
+            const auto path = (std::filesystem::path(folder) / entry.name).string();
+            if (entry.folder) {
+                if (depth < MAX_DEPTH) {
+                    folders.push_back({ path, depth + 1 });
+                }
+                continue;
+            }
+
+            // Only what a decoder would pick from its name, the content is read if unknown or changed
+            if (mRegistry.find(path) < 0) {
+                continue;
+            }
+
+            if (const auto record = known.find(path);
+                record != known.end() && record->second->size == entry.size && record->second->modified == entry.modified) {
+
+                records.push_back(*record->second);
+                known.erase(record);
+                continue;
+            }
+            known.erase(path);
+
+            // Let the live audio refill its read ahead first
+            while (mRunning && mIsBusy()) {
+                SDL_Delay(20);
+            }
+
+            // Unreadable songs are kept too, so they are not opened again until they change
+            Record record = {
+                .path = path,
+                .size = entry.size,
+                .modified = entry.modified,
+                .decoder = "",
+                .title = "",
+                .author = "",
+                .trackCount = 0,
+                .duration = 0
+            };
+            readHeader(fileSystem, record);
+            records.push_back(std::move(record));
+            opened++;
+        }
+
+        if (opened >= CHECKPOINT_RECORDS || (opened > 0 && SDL_GetTicks() - checkpointTime >= CHECKPOINT_INTERVAL)) {
+            checkpoint(records, known);
+            checkpointTime = SDL_GetTicks();
+            opened = 0;
+        }
+    }
+
+    // Stopped halfway, the songs already opened are not opened again next time
+    if (!mRunning && opened > 0) {
+        checkpoint(records, known);
+    }
+}
+
+bool LibraryIndexer::readHeader(const std::shared_ptr<FileSystem> fileSystem, Record& record) {
+    const auto file = fileSystem->getFile(record.path);
+    const auto content = file != nullptr ? file->getContent() : nullptr;
+    if (content == nullptr) {
+        return false;
+    }
+
+    const auto index = mRegistry.find(record.path, content->getView());
+    // Nothing to remember, each song is opened once
+    mRegistry.forget(record.path);
+    if (index < 0) {
+        return false;
+    }
+
+    // Only the header is read, the whole opening is done under the lock
+    const auto decoder = mDecoderList[index];
+    SDL_LockMutex(mLifecycleMutex);
+    if (!decoder->setup() || !decoder->play(content->getView(), mSettings)) {
+        decoder->stop();
+        SDL_UnlockMutex(mLifecycleMutex);
+        return false;
+    }
+
+    const auto metaData = decoder->getMetaData();
+    decoder->stop();
+    SDL_UnlockMutex(mLifecycleMutex);
+
+    // Many disks only name their tracks, each field comes from the first one set
+    const auto& disk = metaData.diskInformation;
+    const auto& track = metaData.trackInformation;
+    const auto hasDisk = metaData.hasDiskInformation;
+    record.decoder = decoder->getName();
+    record.title = hasDisk && !disk.title.empty() ? disk.title : track.title;
+    record.author = hasDisk && !disk.author.empty() ? disk.author : track.author;
+    record.trackCount = hasDisk && disk.trackCount > 0 ? disk.trackCount : 1;
+    record.duration = hasDisk && disk.duration > 0 ? disk.duration : track.duration;
+
+    return true;
+}
+
+std::string LibraryIndexer::escape(const std::string& value) {
+    auto escaped = value;
+    std::replace_if(escaped.begin(), escaped.end(), [](const char c) {
+        return c == '\t' || c == '\n' || c == '\r';
+    }, ' ');
+
+    return escaped;
+}
+
+int LibraryIndexer::indexerThreadFunc(void* userData) {
+    const auto indexer = static_cast<LibraryIndexer*>(userData);
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    indexer->loadIndex();
+    indexer->publishSearch();
+
+    while (indexer->mRunning) {
+        SDL_LockMutex(indexer->mScanMutex);
+        while (indexer->mRunning && !indexer->mScanRequested) {
+            SDL_CondWait(indexer->mScanCond, indexer->mScanMutex);
+        }
+        indexer->mScanRequested = false;
+        SDL_UnlockMutex(indexer->mScanMutex);
+
+        indexer->mScanning = true;
+        indexer->mFresh = false;
+        for (const auto& fileSystem : indexer->mFileSystemList) {
+            if (!indexer->mRunning) {
+                break;
+            }
+
+            const auto startTime = SDL_GetTicks();
+            const auto mountPoint = fileSystem->getMountPoint();
+            const auto previous = indexer->getRecords();
+            std::unordered_map<std::string, const Record*> known;
+            known.reserve(previous->size());
+            for (const auto& record : *previous) {
+                known[record.path] = &record;
+            }
+
+            std::vector<Record> records;
+            indexer->scan(fileSystem, known, records);
+            if (!indexer->mRunning) {
+                break;
+            }
+
+            // The other mount points are kept as they are, "/mnt/music2" is not below "/mnt/music"
+            auto prefix = mountPoint;
+            if (prefix.empty() || prefix.back() != '/') {
+                prefix.push_back('/');
+            }
+            const auto scanned = records.size();
+            for (const auto& record : *previous) {
+                if (record.path.compare(0, prefix.size(), prefix) != 0) {
+                    records.push_back(record);
+                }
+            }
+
+            indexer->publish(records);
+            if (!indexer->saveIndex(*indexer->getRecords())) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Library index: cannot save %s\n", indexer->mIndexPath.c_str());
+            }
+            indexer->publishSearch();
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Library index: %zu songs in %s (%u ms)\n",
+                scanned, mountPoint.c_str(), SDL_GetTicks() - startTime);
+        }
+        indexer->mFresh = indexer->mRunning.load();
+        indexer->mScanning = false;
+    }
+
+    return 0;
+}
+
+int LibraryIndexer::searchThreadFunc(void* userData) {
+    const auto indexer = static_cast<LibraryIndexer*>(userData);
+
+    SDL_LockMutex(indexer->mSearchMutex);
+    while (indexer->mRunning) {
+        if (!indexer->mSearchRequested) {
+            SDL_CondWait(indexer->mSearchCond, indexer->mSearchMutex);
+            continue;
+        }
+
+        const auto query = indexer->mSearchQuery;
+        const auto maxResults = indexer->mMaxSearchResults;
+        indexer->mSearchRequested = false;
+        SDL_UnlockMutex(indexer->mSearchMutex);
+
+        auto results = std::make_shared<std::vector<Record>>();
+        if (const auto searchIndex = std::atomic_load(&indexer->mSearchIndex);
+            searchIndex != nullptr) {
+
+            searchIndex->find(query, maxResults, *results);
+        }
+
+        // Dropped if the query changed meanwhile, the next one replaces them shortly
+        SDL_LockMutex(indexer->mSearchMutex);
+        if (!indexer->mSearchRequested) {
+            std::atomic_store(&indexer->mSearchResults, Records(results));
+            indexer->mSearchGeneration.fetch_add(1, std::memory_order_release);
+        }
+    }
+    SDL_UnlockMutex(indexer->mSearchMutex);
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "filesystem/filesystem.h"
+#include "decoder/decoder.h"
+#include "decoder/decoderregistry.h"
+#include "settings.h"
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+
+class SearchIndex;
+
+// Walk all the mount points in a low priority thread and keep the playable
+// songs with their header informations in an index file. Songs with the same
+// size and modification time as in the index are not opened again.
+class LibraryIndexer {
+
+    public:
+        struct Record {
+            std::string path;
+            uintmax_t size;
+            int64_t modified;
+            std::string decoder;
+            std::string title;
+            std::string author;
+            int trackCount;
+            int duration;
+        };
+
+        // Immutable and sorted by path, replaced as a whole while and after scanning each mount point
+        typedef std::shared_ptr<const std::vector<Record>> Records;
+
+        LibraryIndexer();
+        virtual ~LibraryIndexer();
+
+        // Headers are read with the settings songs are played with
+        bool setup(const std::filesystem::path dataPath, const std::filesystem::path indexPath,
+            const std::vector<std::shared_ptr<FileSystem>>& fileSystemList, std::shared_ptr<Settings> settings,
+            SDL_mutex* lifecycleMutex, const std::function<bool ()>& isBusy);
+        void cleanup();
+
+        void rescan();
+        bool isScanning() const;
+
+        Records getRecords() const;
+        Uint32 getGeneration() const;
+        // Folder songs and sub folders holding songs from the index only, false until a
+        // scan of this session completed, during a rescan or if nothing is indexed below path
+        bool navigate(const std::string path, std::vector<FileSystem::Entry>& list) const;
+        // Songs whose file name, title or author contain the query, found by a worker thread
+        // and run again when the search index changes. Only the last query posted is run.
+        void search(const std::string& query, const size_t maxResults);
+        Records getSearchResults() const;
+        Uint32 getSearchGeneration() const;
+
+    private:
+        static const int INDEX_VERSION;
+        static const int MAX_DEPTH;
+        static const Uint32 CHECKPOINT_INTERVAL;
+        static const size_t CHECKPOINT_RECORDS;
+
+        std::filesystem::path mIndexPath;
+        std::filesystem::path mSearchPath;
+        Records mRecords;
+        std::shared_ptr<const SearchIndex> mSearchIndex;
+        std::atomic<Uint32> mGeneration;
+
+        SDL_Thread* mSearchThread;
+        SDL_mutex* mSearchMutex;
+        SDL_cond* mSearchCond;
+        std::string mSearchQuery;
+        size_t mMaxSearchResults;
+        bool mSearchRequested;
+        Records mSearchResults;
+        std::atomic<Uint32> mSearchGeneration;
+
+        SDL_Thread* mThread;
+        SDL_mutex* mScanMutex;
+        SDL_cond* mScanCond;
+        std::atomic<bool> mRunning;
+        std::atomic<bool> mScanning;
+        std::atomic<bool> mFresh;
+        bool mScanRequested;
+
+        std::vector<std::shared_ptr<FileSystem>> mFileSystemList;
+        std::vector<std::shared_ptr<Decoder>> mDecoderList;
+        DecoderRegistry mRegistry;
+        std::shared_ptr<Settings> mSettings;
+        SDL_mutex* mLifecycleMutex;
+        std::function<bool ()> mIsBusy;
+
+        LibraryIndexer(const LibraryIndexer& copy);
+
+        void loadIndex();
+        bool saveIndex(const std::vector<Record>& records) const;
+        void publish(std::vector<Record>& records);
+        void publishSearch();
+        void requestSearch();
+        void checkpoint(const std::vector<Record>& records, const std::unordered_map<std::string, const Record*>& known);
+        // Songs found are removed from known, what is left was not reached or is gone
+        void scan(const std::shared_ptr<FileSystem> fileSystem, std::unordered_map<std::string, const Record*>& known,
+            std::vector<Record>& records);
+        bool readHeader(const std::shared_ptr<FileSystem> fileSystem, Record& record);
+
+        static std::string escape(const std::string& value);
+        static int indexerThreadFunc(void* userData);
+        static int searchThreadFunc(void* userData);
+
+};
@@ -0,0 +1,259 @@
+#include "loudnessanalyzer.h"
+
+#include "decoder/decoderfactory.h"
+#include "audio/loudnessmeter.h"
+#include "audio/samplekernels.h"
+
+#include <algorithm>
+#include <fstream>
+#include <SDL2/SDL_log.h>
+#include <SDL2/SDL_timer.h>
+
+const float LoudnessAnalyzer::TARGET_LOUDNESS = -18.0f;
+// Songs without end are measured on their beginning only
+const int LoudnessAnalyzer::MAX_DURATION = 180;
+const int LoudnessAnalyzer::CHUNK_FRAMES = 4096;
+
+LoudnessAnalyzer::LoudnessAnalyzer() :
+    mCacheMutex(SDL_CreateMutex()),
+    mThread(nullptr),
+    mQueueMutex(SDL_CreateMutex()),
+    mQueueCond(SDL_CreateCond()),
+    mRunning(false),
+    mLifecycleMutex(nullptr) {
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer() {
+    cleanup();
+
+    if (mCacheMutex != nullptr) {
+        SDL_DestroyMutex(mCacheMutex);
+        mCacheMutex = nullptr;
+    }
+
+    if (mQueueMutex != nullptr) {
+        SDL_DestroyMutex(mQueueMutex);
+        mQueueMutex = nullptr;
+    }
+
+    if (mQueueCond != nullptr) {
+        SDL_DestroyCond(mQueueCond);
+        mQueueCond = nullptr;
+    }
+}
+
+bool LoudnessAnalyzer::setup(const std::filesystem::path dataPath, const std::filesystem::path cachePath,
+    std::shared_ptr<Settings> settings, SDL_mutex* lifecycleMutex, const std::function<bool ()>& isBusy,
+    const std::function<void (const uint64_t hash, const Result& result)>& onResult) {
+
+    mCachePath = cachePath;
+    mLifecycleMutex = lifecycleMutex;
+    mIsBusy = isBusy;
+    mOnResult = onResult;
+    mSettings = settings;
+    mDecoderList = DecoderFactory(dataPath).createList();
+    mRegistry.setup(mDecoderList);
+    loadCache();
+
+    mRunning = true;
+    if (mThread = SDL_CreateThread(LoudnessAnalyzer::analyzerThreadFunc, "OSP-Loudness-Thread", this);
+        mThread == nullptr) {
+
+        mRunning = false;
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unable to start loudness analyzer: %s\n", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void LoudnessAnalyzer::cleanup() {
+    if (mThread != nullptr) {
+        SDL_LockMutex(mQueueMutex);
+        mRunning = false;
+        mPriorityQueue.clear();
+        mBackgroundQueue.clear();
+        SDL_CondSignal(mQueueCond);
+        SDL_UnlockMutex(mQueueMutex);
+
+        SDL_WaitThread(mThread, nullptr);
+        mThread = nullptr;
+    }
+
+    mRegistry.cleanup();
+}
+
+bool LoudnessAnalyzer::getResult(const uint64_t hash, Result& result) const {
+    SDL_LockMutex(mCacheMutex);
+    const auto found = mCache.find(hash);
+    if (found != mCache.end()) {
+        result = found->second;
+    }
+    SDL_UnlockMutex(mCacheMutex);
+
+    return found != mCache.end();
+}
+
+void LoudnessAnalyzer::analyze(const std::shared_ptr<File> file) {
+    if (file == nullptr || !mRunning) {
+        return;
+    }
+
+    SDL_LockMutex(mQueueMutex);
+    mPriorityQueue.push_back(file);
+    SDL_CondSignal(mQueueCond);
+    SDL_UnlockMutex(mQueueMutex);
+}
+
+void LoudnessAnalyzer::analyzeBackground(const std::vector<std::shared_ptr<File>>& files) {
+    if (!mRunning) {
+        return;
+    }
+
+    SDL_LockMutex(mQueueMutex);
+    mBackgroundQueue.assign(files.begin(), files.end());
+    SDL_CondSignal(mQueueCond);
+    SDL_UnlockMutex(mQueueMutex);
+}
+
+// Gain in dB to bring a song to the target loudness, the limiter takes care of the peaks
+float LoudnessAnalyzer::getTrackGain(const Result& result) {
+    if (result.loudness <= LoudnessMeter::SILENCE) {
+        return 0.0f;
+    }
+
+    return std::clamp(TARGET_LOUDNESS - result.loudness, -20.0f, 15.0f);
+}
+
+void LoudnessAnalyzer::loadCache() {
+    std::ifstream is(mCachePath);
+    if (!is.good()) {
+        return;
+    }
+
+    uint64_t hash;
+    Result result;
+    SDL_LockMutex(mCacheMutex);
+    while (is >> std::hex >> hash >> std::dec >> result.loudness >> result.truePeak) {
+        mCache[hash] = result;
+    }
+    SDL_UnlockMutex(mCacheMutex);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Loudness cache: %zu songs.\n", mCache.size());
+}
+
+void LoudnessAnalyzer::saveResult(const uint64_t hash, const Result& result) {
+    SDL_LockMutex(mCacheMutex);
+    mCache[hash] = result;
+    SDL_UnlockMutex(mCacheMutex);
+
+    // Append only, the last line of a hash wins when loading
+    std::ofstream os(mCachePath, std::ios::app);
+    if (os.good()) {
+        os << std::hex << hash << std::dec << " " << result.loudness << " " << result.truePeak << "\n";
+    }
+}
+
+bool LoudnessAnalyzer::measure(const std::shared_ptr<Decoder> decoder, const FileView content, Result& result) {
+    SDL_LockMutex(mLifecycleMutex);
+    auto success = decoder->setup() && decoder->play(content, mSettings);
+    SDL_UnlockMutex(mLifecycleMutex);
+
+    const auto format = decoder->getAudioSampleFormat();
+    const auto channels = decoder->getAudioChannels();
+    const auto frequency = decoder->getAudioFrequency();
+
+    LoudnessMeter meter;
+    success = success && (format == AUDIO_S16SYS || format == AUDIO_F32SYS) && meter.setup(frequency, channels);
+
+    if (success) {
+        const auto frameSize = channels * (SDL_AUDIO_BITSIZE(format) / 8);
+        const auto trackNumber = decoder->getMetaData().trackInformation.trackNumber;
+        const auto maxFrames = (uint64_t) MAX_DURATION * frequency;
+        std::vector<Uint8> stream(CHUNK_FRAMES * frameSize);
+        std::vector<float> samples(CHUNK_FRAMES * channels);
+
+        for (uint64_t frames = 0; frames < maxFrames && mRunning;) {
+            // Let the live audio refill its read ahead first
+            while (mRunning && mIsBusy()) {
+                SDL_Delay(20);
+            }
+
+            const auto retCode = decoder->process(stream.data(), stream.size());
+            if (retCode < 0) {
+                success = false;
+                break;
+            }
+
+            const auto rendered = (retCode == 1 ? decoder->getRenderedLength() : stream.size()) / frameSize;
+            if (format == AUDIO_F32SYS) {
+                meter.process((const float*) stream.data(), rendered);
+            } else {
+                SampleKernels::convertS16ToFloat((const Sint16*) stream.data(), samples.data(), rendered * channels);
+                meter.process(samples.data(), rendered);
+            }
+            frames += rendered;
+
+            // Only the first sub tune is measured
+            if (retCode == 1 || decoder->getMetaData().trackInformation.trackNumber != trackNumber) {
+                break;
+            }
+        }
+        success = success && mRunning;
+    }
+
+    SDL_LockMutex(mLifecycleMutex);
+    decoder->stop();
+    decoder->cleanup();
+    SDL_UnlockMutex(mLifecycleMutex);
+
+    if (success) {
+        result.loudness = meter.getIntegratedLoudness();
+        result.truePeak = meter.getTruePeak();
+    }
+    return success;
+}
+
+int LoudnessAnalyzer::analyzerThreadFunc(void* userData) {
+    const auto analyzer = static_cast<LoudnessAnalyzer*>(userData);
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    while (analyzer->mRunning) {
+        SDL_LockMutex(analyzer->mQueueMutex);
+        while (analyzer->mRunning && analyzer->mPriorityQueue.empty() && analyzer->mBackgroundQueue.empty()) {
+            SDL_CondWait(analyzer->mQueueCond, analyzer->mQueueMutex);
+        }
+
+        std::shared_ptr<File> file;
+        auto& queue = analyzer->mPriorityQueue.empty() ? analyzer->mBackgroundQueue : analyzer->mPriorityQueue;
+        if (!queue.empty()) {
+            file = queue.front();
+            queue.pop_front();
+        }
+        SDL_UnlockMutex(analyzer->mQueueMutex);
+
+        // From the content, badly named songs are measured too
+        const auto content = file != nullptr ? file->getContent() : nullptr;
+        const auto index = content != nullptr ? analyzer->mRegistry.find(file->getPath(), content->getView()) : -1;
+        if (index < 0) {
+            continue;
+        }
+        // Results are kept by content hash, the decoder found is not needed again
+        analyzer->mRegistry.forget(file->getPath());
+
+        Result result;
+        const auto hash = content->getView().getHash();
+        if (analyzer->getResult(hash, result)) {
+            continue;
+        }
+
+        const auto startTime = SDL_GetTicks();
+        if (analyzer->measure(analyzer->mDecoderList[index], content->getView(), result)) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Loudness of %s: %.1f LUFS, %.1f dBTP (%u ms)\n",
+                file->getPath().c_str(), result.loudness, result.truePeak, SDL_GetTicks() - startTime);
+            analyzer->saveResult(hash, result);
+            analyzer->mOnResult(hash, result);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "filesystem/file.h"
+#include "decoder/decoder.h"
+#include "decoder/decoderregistry.h"
+#include "settings.h"
+
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+
+// Measure songs loudness in a low priority thread with its own decoders,
+// results are kept in a cache file keyed by the content hash of the songs.
+class LoudnessAnalyzer {
+
+    public:
+        // ReplayGain 2.0 reference level
+        static const float TARGET_LOUDNESS;
+
+        struct Result {
+            float loudness;
+            float truePeak;
+        };
+
+        LoudnessAnalyzer();
+        virtual ~LoudnessAnalyzer();
+
+        // Songs are measured with the settings they are played with
+        bool setup(const std::filesystem::path dataPath, const std::filesystem::path cachePath,
+            std::shared_ptr<Settings> settings, SDL_mutex* lifecycleMutex, const std::function<bool ()>& isBusy,
+            const std::function<void (const uint64_t hash, const Result& result)>& onResult);
+        void cleanup();
+
+        bool getResult(const uint64_t hash, Result& result) const;
+
+        // Priority songs are analyzed first, the others replace the previous background queue
+        void analyze(const std::shared_ptr<File> file);
+        void analyzeBackground(const std::vector<std::shared_ptr<File>>& files);
+
+        static float getTrackGain(const Result& result);
+
+    private:
+        static const int MAX_DURATION;
+        static const int CHUNK_FRAMES;
+
+        std::filesystem::path mCachePath;
+        std::unordered_map<uint64_t, Result> mCache;
+        SDL_mutex* mCacheMutex;
+
+        SDL_Thread* mThread;
+        SDL_mutex* mQueueMutex;
+        SDL_cond* mQueueCond;
+        std::atomic<bool> mRunning;
+        std::deque<std::shared_ptr<File>> mPriorityQueue;
+        std::deque<std::shared_ptr<File>> mBackgroundQueue;
+
+        std::vector<std::shared_ptr<Decoder>> mDecoderList;
+        DecoderRegistry mRegistry;
+        std::shared_ptr<Settings> mSettings;
+        SDL_mutex* mLifecycleMutex;
+        std::function<bool ()> mIsBusy;
+        std::function<void (const uint64_t hash, const Result& result)> mOnResult;
+
+        LoudnessAnalyzer(const LoudnessAnalyzer& copy);
+
+        void loadCache();
+        void saveResult(const uint64_t hash, const Result& result);
+        bool measure(const std::shared_ptr<Decoder> decoder, const FileView content, Result& result);
+
+        static int analyzerThreadFunc(void* userData);
+
+};
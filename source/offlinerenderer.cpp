@@ -0,0 +1,282 @@
+#include "offlinerenderer.h"
+
+#include "decoder/decoderfactory.h"
+#include "audio/wavwriter.h"
+
+#include <algorithm>
+#include <SDL2/SDL_log.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_timer.h>
+
+// Frames rendered per Decoder::process call
+static const int RENDER_CHUNK_FRAMES = 4096;
+
+OfflineRenderer::OfflineRenderer(const std::filesystem::path dataPath, std::shared_ptr<Settings> settings, const int workerCount) :
+    mSettings(settings),
+    mLifecycleMutex(SDL_CreateMutex()),
+    mResultMutex(SDL_CreateMutex()),
+    mMaxDuration(180) {
+
+    for (auto i=0; i<std::max(workerCount, 1); i++) {
+        mDecoderLists.push_back(DecoderFactory(dataPath).createList());
+    }
+    // All lists hold the same decoders in the same order
+    mRegistry.setup(mDecoderLists.front());
+}
+
+OfflineRenderer::~OfflineRenderer() {
+    mRegistry.cleanup();
+    mDecoderLists.clear();
+
+    if (mLifecycleMutex != nullptr) {
+        SDL_DestroyMutex(mLifecycleMutex);
+        mLifecycleMutex = nullptr;
+    }
+
+    if (mResultMutex != nullptr) {
+        SDL_DestroyMutex(mResultMutex);
+        mResultMutex = nullptr;
+    }
+}
+
+void OfflineRenderer::setMaxDuration(const int seconds) {
+    mMaxDuration = seconds;
+}
+
+int OfflineRenderer::getWorkerCount() const {
+    return mDecoderLists.size();
+}
+
+bool OfflineRenderer::canRender(const std::shared_ptr<File> file) {
+    const auto content = file->getContent();
+    return content != nullptr && mRegistry.find(file->getPath(), content->getView()) >= 0;
+}
+
+std::vector<OfflineRenderer::Job> OfflineRenderer::expandTracks(const std::vector<Job>& jobs) {
+    // Probe the track count of each file in parallel
+    std::vector<int> trackCounts(jobs.size(), 1);
+    runParallel(jobs.size(), [&](DecoderList& decoderList, const size_t index) {
+        if (jobs[index].track != ALL_TRACKS) {
+            return;
+        }
+
+        std::string error;
+        if (const auto decoder = openDecoder(decoderList, jobs[index].file, DEFAULT_TRACK, error);
+            decoder != nullptr) {
+
+            const auto metaData = decoder->getMetaData();
+            if (metaData.hasDiskInformation && metaData.diskInformation.trackCount > 1) {
+                trackCounts[index] = metaData.diskInformation.trackCount;
+            }
+            closeDecoder(decoder);
+        }
+    });
+
+    std::vector<Job> expandedJobs;
+    for (size_t i=0; i<jobs.size(); i++) {
+        const auto& job = jobs[i];
+        if (job.track != ALL_TRACKS || trackCounts[i] <= 1) {
+            expandedJobs.push_back({
+                .file = job.file,
+                .track = job.track == ALL_TRACKS ? DEFAULT_TRACK : job.track,
+                .output = job.output
+            });
+            continue;
+        }
+
+        char suffix[16];
+        for (auto track=1; track<=trackCounts[i]; track++) {
+            snprintf(suffix, sizeof(suffix), "-%02d.wav", track);
+            auto output = job.output;
+            output.replace_filename(job.output.stem().string().append(suffix));
+            expandedJobs.push_back({
+                .file = job.file,
+                .track = track,
+                .output = output
+            });
+        }
+    }
+
+    return expandedJobs;
+}
+
+std::vector<OfflineRenderer::Result> OfflineRenderer::render(const std::vector<Job>& jobs,
+    const std::function<void (const Result&)>& onJobDone) {
+
+    std::vector<Result> results(jobs.size());
+    runParallel(jobs.size(), [&](DecoderList& decoderList, const size_t index) {
+        results[index] = renderJob(decoderList, jobs[index]);
+
+        SDL_LockMutex(mResultMutex);
+        onJobDone(results[index]);
+        SDL_UnlockMutex(mResultMutex);
+    });
+
+    return results;
+}
+
+void OfflineRenderer::runParallel(const size_t count, const Task& task) {
+    std::atomic<size_t> nextIndex(0);
+    std::vector<Worker> workers(std::min(mDecoderLists.size(), count));
+    std::vector<SDL_Thread*> threads;
+
+    for (size_t i=0; i<workers.size(); i++) {
+        workers[i] = {
+            .renderer = this,
+            .decoderList = &mDecoderLists[i],
+            .task = &task,
+            .nextIndex = &nextIndex,
+            .count = count
+        };
+
+        if (const auto thread = SDL_CreateThread(OfflineRenderer::workerThreadFunc, "OSP-Render-Thread", &workers[i]);
+            thread != nullptr) {
+
+            threads.push_back(thread);
+        } else {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unable to start render thread: %s\n", SDL_GetError());
+        }
+    }
+
+    // Still do the work if no thread could be started
+    if (threads.empty() && !workers.empty()) {
+        workerThreadFunc(&workers[0]);
+    }
+
+    for (const auto thread : threads) {
+        SDL_WaitThread(thread, nullptr);
+    }
+}
+
+int OfflineRenderer::workerThreadFunc(void* userData) {
+    const auto worker = static_cast<Worker*>(userData);
+
+    for (auto index = worker->nextIndex->fetch_add(1); index < worker->count; index = worker->nextIndex->fetch_add(1)) {
+        (*worker->task)(*worker->decoderList, index);
+    }
+
+    return 0;
+}
+
+std::shared_ptr<Decoder> OfflineRenderer::openDecoder(DecoderList& decoderList, const std::shared_ptr<File> file,
+    const int track, std::string& error) {
+
+    const auto content = file->getContent();
+    if (content == nullptr) {
+        error = std::string("Can't open file: ").append(file->getError());
+        return nullptr;
+    }
+
+    const auto index = mRegistry.find(file->getPath(), content->getView());
+    if (index < 0) {
+        error = "No decoder can handle this file.";
+        return nullptr;
+    }
+    const auto decoder = decoderList[index];
+
+    // Decoders setup and play touch libraries global state, never run them concurrently
+    SDL_LockMutex(mLifecycleMutex);
+    const auto isPlaying = decoder->setup() && decoder->play(content->getView(), mSettings);
+    SDL_UnlockMutex(mLifecycleMutex);
+
+    if (!isPlaying) {
+        mRegistry.forget(file->getPath());
+        error = decoder->getError();
+        closeDecoder(decoder);
+        return nullptr;
+    }
+
+    // Walk to the requested sub tune
+    if (track != DEFAULT_TRACK) {
+        auto currentTrack = decoder->getMetaData().trackInformation.trackNumber;
+        while (currentTrack != track) {
+            if (!(currentTrack < track ? decoder->nextTrack() : decoder->prevTrack())) {
+                error = "Can't select track.";
+                closeDecoder(decoder);
+                return nullptr;
+            }
+            currentTrack = decoder->getMetaData().trackInformation.trackNumber;
+        }
+    }
+
+    return decoder;
+}
+
+void OfflineRenderer::closeDecoder(std::shared_ptr<Decoder> decoder) {
+    SDL_LockMutex(mLifecycleMutex);
+    decoder->stop();
+    decoder->cleanup();
+    SDL_UnlockMutex(mLifecycleMutex);
+}
+
+OfflineRenderer::Result OfflineRenderer::renderJob(DecoderList& decoderList, const Job& job) {
+    Result result = {
+        .job = job,
+        .success = false,
+        .error = "",
+        .frames = 0,
+        .frequency = 0,
+        .elapsed = 0
+    };
+
+    const auto startTime = SDL_GetPerformanceCounter();
+    const auto decoder = openDecoder(decoderList, job.file, job.track, result.error);
+    if (decoder == nullptr) {
+        return result;
+    }
+
+    const auto frequency = decoder->getAudioFrequency();
+    const auto channels = decoder->getAudioChannels();
+    const auto frameSize = channels * (SDL_AUDIO_BITSIZE(decoder->getAudioSampleFormat()) / 8);
+    const auto trackInformation = decoder->getMetaData().trackInformation;
+
+    // A single sub tune stop at its known duration or when the decoder move to another one
+    auto maxDuration = mMaxDuration;
+    if (job.track != DEFAULT_TRACK && trackInformation.duration > 0) {
+        maxDuration = std::min(maxDuration, trackInformation.duration + 1);
+    }
+    const auto maxFrames = (uint64_t) maxDuration * frequency;
+
+    WavWriter wavWriter;
+    if (!wavWriter.open(job.output, frequency, channels)) {
+        result.error = wavWriter.getError();
+        closeDecoder(decoder);
+        return result;
+    }
+
+    std::vector<Uint8> buffer(RENDER_CHUNK_FRAMES * frameSize);
+    while (result.frames < maxFrames) {
+        const auto frames = (int) std::min((uint64_t) RENDER_CHUNK_FRAMES, maxFrames - result.frames);
+        const auto retCode = decoder->process(buffer.data(), frames * frameSize);
+        if (retCode < 0) {
+            result.error = decoder->getError();
+            break;
+        }
+
+        const auto rendered = retCode == 1 ? decoder->getRenderedLength() : frames * frameSize;
+        if (!wavWriter.write(buffer.data(), rendered)) {
+            result.error = wavWriter.getError();
+            break;
+        }
+        result.frames += rendered / frameSize;
+
+        if (retCode == 1) {
+            break;
+        }
+
+        if (job.track != DEFAULT_TRACK
+            && decoder->getMetaData().trackInformation.trackNumber != trackInformation.trackNumber) {
+            break;
+        }
+    }
+
+    closeDecoder(decoder);
+    if (!wavWriter.close() && result.error.empty()) {
+        result.error = "Write error.";
+    }
+
+    result.success = result.error.empty();
+    result.frequency = frequency;
+    result.elapsed = (double) (SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+    return result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "filesystem/file.h"
+#include "decoder/decoder.h"
+#include "decoder/decoderregistry.h"
+#include "settings.h"
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SDL2/SDL_mutex.h>
+
+// Render songs to wav files as fast as the CPU allow, without audio device.
+// Jobs are spread on several worker threads, each one owning its own decoders.
+class OfflineRenderer {
+
+    public:
+        static const int DEFAULT_TRACK = 0;
+        static const int ALL_TRACKS = -1;
+
+        struct Job {
+            std::shared_ptr<File> file;
+            int track;
+            std::filesystem::path output;
+        };
+
+        struct Result {
+            Job job;
+            bool success;
+            std::string error;
+            uint64_t frames;
+            int frequency;
+            double elapsed;
+        };
+
+        OfflineRenderer(const std::filesystem::path dataPath, std::shared_ptr<Settings> settings, const int workerCount);
+        virtual ~OfflineRenderer();
+
+        void setMaxDuration(const int seconds);
+        int getWorkerCount() const;
+        // From the content, the decoder found is kept for the render
+        bool canRender(const std::shared_ptr<File> file);
+
+        std::vector<Job> expandTracks(const std::vector<Job>& jobs);
+        std::vector<Result> render(const std::vector<Job>& jobs, const std::function<void (const Result&)>& onJobDone);
+
+    private:
+        typedef std::vector<std::shared_ptr<Decoder>> DecoderList;
+        typedef std::function<void (DecoderList& decoderList, const size_t index)> Task;
+
+        struct Worker {
+            OfflineRenderer* renderer;
+            DecoderList* decoderList;
+            const Task* task;
+            std::atomic<size_t>* nextIndex;
+            size_t count;
+        };
+
+        std::shared_ptr<Settings> mSettings;
+        std::vector<DecoderList> mDecoderLists;
+        DecoderRegistry mRegistry;
+        SDL_mutex* mLifecycleMutex;
+        SDL_mutex* mResultMutex;
+        int mMaxDuration;
+
+        OfflineRenderer(const OfflineRenderer& copy);
+
+        void runParallel(const size_t count, const Task& task);
+        std::shared_ptr<Decoder> openDecoder(DecoderList& decoderList, const std::shared_ptr<File> file,
+            const int track, std::string& error);
+        void closeDecoder(std::shared_ptr<Decoder> decoder);
+        Result renderJob(DecoderList& decoderList, const Job& job);
+
+        static int workerThreadFunc(void* userData);
+
+};
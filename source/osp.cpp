@@ -15,10 +15,13 @@ Osp::Osp() :
     mTextureSprites(0),
     mStatusMessage("Initializing..."),
     mLastFileSelected(""),
+    mLoudnessBrowsedGeneration(0),
+    mSearchGeneration(0),
     mSettings(nullptr),
     mSpriteCatalog(nullptr),
     mFileManager(nullptr),
-    mSoundEngine(nullptr) {
+    mSoundEngine(nullptr),
+    mLibraryIndexer(nullptr) {
 }
 
 Osp::~Osp() {
@@ -57,7 +60,8 @@ bool Osp::setup(const std::string dataPath) {
 
     // Setup sound engine
     mSoundEngine = std::unique_ptr<SoundEngine>(new SoundEngine());
-    if (!mSoundEngine->setup(dataPath.c_str())) {
+    if (!mSoundEngine->setup(dataPath.c_str(), LOUDNESS_CACHE_FILENAME, mSettings,
+        mSettings->getBool(KEY_APP_LOW_LATENCY, APP_LOW_LATENCY_DEFAULT))) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to initialize SoundEngine.\n");
         return false;
     }
@@ -70,6 +74,9 @@ bool Osp::setup(const std::string dataPath) {
         case 2: ImGui::StyleColorsClassic(); break;
     }
 
+    mSoundEngine->setVolume(mSettings->getInt(KEY_APP_VOLUME, APP_VOLUME_DEFAULT));
+    mSoundEngine->setCrossfade(mSettings->getInt(KEY_APP_CROSSFADE, APP_CROSSFADE_DEFAULT));
+
     const auto font = mSettings->getInt(KEY_APP_FONT, APP_FONT_DEFAULT);
     if (font >= 0 && font < io.Fonts->Fonts.Size) {
         io.FontDefault = io.Fonts->Fonts[font];
@@ -82,6 +89,23 @@ bool Osp::setup(const std::string dataPath) {
         return false;
     }
 
+    // Restore the queue of the previous session
+    mPlayQueue.load(PLAY_QUEUE_FILENAME);
+
+    // Index the songs of all the mount points in background, paused like the loudness measures
+    mLibraryIndexer = std::unique_ptr<LibraryIndexer>(new LibraryIndexer());
+    if (mSettings->getBool(KEY_APP_LIBRARY_INDEXING, APP_LIBRARY_INDEXING_DEFAULT)) {
+        mLibraryIndexer->setup(dataPath, LIBRARY_INDEX_FILENAME, mFileManager->getFileSystems(), mSettings,
+            mSoundEngine->getLifecycleMutex(), [this]() {
+                return mSoundEngine->isBusy();
+            });
+
+        // Once scanned, browsing the library does not read the folders again
+        mFileManager->setIndexedNavigation([this](const std::string path, std::vector<FileSystem::Entry>& list) {
+            return mLibraryIndexer->navigate(path, list);
+        });
+    }
+
     const auto mouseEmulation = mSettings->getBool(KEY_APP_MOUSE_EMULATION, APP_MOUSE_EMULATION_DEFAULT);
     ImGui_ImplSDL2_SetMouseEmulationWithGamepad(mouseEmulation);
     if (mouseEmulation && !PLATFORM_HAS_MOUSE_CURSOR) {
@@ -100,6 +124,17 @@ bool Osp::setup(const std::string dataPath) {
 }
 
 void Osp::cleanup() {
+    // Save where the playing song is to resume it
+    if (const auto position = mSoundEngine->getPosition();
+        position > 0) {
+
+        mPlayQueue.setCurrentPosition(mSoundEngine->getMetaData()->trackInformation.trackNumber, position);
+    }
+    if (!mPlayQueue.save(PLAY_QUEUE_FILENAME)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Cannot save the play queue to %s\n", PLAY_QUEUE_FILENAME.c_str());
+    }
+
+    mLibraryIndexer->cleanup();
     mSoundEngine->cleanup();
     mFileManager->cleanup();
     mSpriteCatalog->cleanup();
@@ -113,6 +148,7 @@ void Osp::cleanup() {
 void Osp::render() {
     auto& io = ImGui::GetIO();
     const auto songMetaData = mSoundEngine->getMetaData();
+    const auto songPosition = mSoundEngine->getPosition();
     const auto fmState = mFileManager->getState();
     const auto sndState = mSoundEngine->getState();
 
@@ -131,15 +167,35 @@ void Osp::render() {
             mFileManager->clearError();
         } 
 
+        // Found by the indexer, again each time the library changes
+        if (mLibraryIndexer->getSearchGeneration() != mSearchGeneration) {
+            mSearchGeneration = mLibraryIndexer->getSearchGeneration();
+            mSearchResults = mLibraryIndexer->getSearchResults();
+        }
+
+        // Only once per listing, the path changes before its listing is ready
+        if (mFileManager->getListingGeneration() != mLoudnessBrowsedGeneration) {
+            analyzeBrowsedFolder();
+        }
+
         // SoundEngine states
         switch (sndState) {
             case SoundEngine::State::FINISHED_NATURAL: {
                     const auto skipUnsupportedTunes = mSettings->getBool(KEY_APP_SKIP_UNSUPPORTED_TUNES, APP_SKIP_UNSUPPORTED_TUNES_DEFAULT);
-                    selectNextTrack(skipUnsupportedTunes, true);
+                    selectNextTrack(skipUnsupportedTunes, true, true);
                 }
                 break;
             case SoundEngine::State::STARTED:
                 mStatusMessage = STR_PLAYING;
+                if (PlayQueue::Entry entry;
+                    mPlayQueue.getCurrent(entry) && mSoundEngine->getCurrentPath() != entry.path &&
+                    mPlayQueue.peekNext(true, entry) && mSoundEngine->getCurrentPath() == entry.path) {
+
+                    // The engine started the preloaded song by itself
+                    mPlayQueue.next(true);
+                    mLastFileSelected = std::filesystem::path(entry.path).filename().string();
+                    enginePreloadNext();
+                }
                 break;
             case SoundEngine::State::PAUSED:
                 mStatusMessage = STR_PAUSED;
@@ -178,6 +234,9 @@ void Osp::render() {
             .fmState = fmState,
             .itemShowWorkspaceCheked = mShowWorkspace,
             .settings = mSettings,
+            .shuffle = mPlayQueue.isShuffled(),
+            .repeat = mPlayQueue.getRepeat(),
+            .queueSize = mPlayQueue.getSize()
         },
         [&](int style) {
             handleStyleChange(style);
@@ -204,10 +263,21 @@ void Osp::render() {
                 .currentPath = mFileManager->getCurrentPath(),
                 .listing = mFileManager->getCurrentPathEntries(),
                 .selectedItemName = selectedItem,
-                .isWorking = fmState == FileManager::State::LOADING
+                .isWorking = fmState == FileManager::State::LOADING,
+                .canSearch = mLibraryIndexer->getRecords()->size() > 0,
+                .searchResults = mSearchResults
             },
             [&](FileSystem::Entry item) {
                 handleExplorerItemClick(item, mFileManager->getCurrentPath());
+            },
+            [&](FileSystem::Entry item) {
+                handleEnqueue((mFileManager->getCurrentPath() / item.name).string());
+            },
+            [&](const std::string& query) {
+                handleSearchChange(query);
+            },
+            [&](const LibraryIndexer::Record& record) {
+                handleSearchResultClick(record);
             });
 
         ImGui::NextColumn();
@@ -217,16 +287,21 @@ void Osp::render() {
                 .texture = mTextureSprites,
                 .state = sndState,
                 .metaData = songMetaData,
+                .position = songPosition,
                 .catalog = mSpriteCatalog
             },
             [&](PlayerFrame::ButtonId button) { 
                 handlePlayerButtonClick(button);
+            },
+            [&](int position) {
+                mSoundEngine->seek(position);
             });
 
         // Song meta data
         mMetaDataFrame.render({
                 .state = sndState,
-                .metaData = songMetaData
+                .metaData = songMetaData,
+                .position = songPosition
             });
 
         ImGui::Columns(1);
@@ -240,126 +315,88 @@ void Osp::render() {
         [&](SettingsWindow::AppSetting setting, bool value) {
             handleAppSettingsChange(setting, value);
         },
+        [&](int volume) {
+            mSettings->putInt(KEY_APP_VOLUME, volume);
+            mSoundEngine->setVolume(volume);
+        },
         [&](std::string key, int value) {
             mSettings->putInt(key, value);
             mSettings->save(CONFIG_FILENAME);
+            if (key == KEY_APP_VOLUME) {
+                mSoundEngine->setVolume(value);
+            } else if (key == KEY_APP_CROSSFADE) {
+                mSoundEngine->setCrossfade(value);
+            }
         },
         [&](std::string key, bool value) {
             mSettings->putBool(key, value);
             mSettings->save(CONFIG_FILENAME);
         });
 
-    mMetricsWindow.render();
+    mMetricsWindow.render(mSoundEngine->getMetrics(),
+        [&]() {
+            mSoundEngine->getMetrics().reset();
+        },
+        [&]() {
+            if (mSoundEngine->getMetrics().dump(AUDIO_METRICS_FILENAME)) {
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Audio metrics written to %s\n", AUDIO_METRICS_FILENAME.c_str());
+            } else {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot write audio metrics to %s\n", AUDIO_METRICS_FILENAME.c_str());
+            }
+        });
     mAboutWindow.render(mTextureSprites, mSpriteCatalog);
 }
 
-void Osp::selectNextTrack(bool skipInvalid, bool autoPlay) {
+void Osp::selectNextTrack(bool skipInvalid, bool autoPlay, bool automatic) {
     const auto skipSubTunes = mSettings->getBool(KEY_APP_SKIP_SUBTUNES, APP_SKIP_SUBTUNES_DEFAULT);
-    if (skipSubTunes || !mSoundEngine->nextTrack()) {
-        if (const auto nextFileName = getNextFileName();
-            nextFileName.empty() == false) {
-
-            if (!engineLoad(mFileManager->getCurrentPath(), nextFileName)) {
-                // Go until we found something to play
-                if (skipInvalid) {
-                    selectNextTrack(skipInvalid, autoPlay);
-                }
-            } else if (autoPlay) {
-                mSoundEngine->play();
-            }
-        }
-        else {
-            mSoundEngine->stop();
-        }
+    if (!skipSubTunes && mSoundEngine->nextTrack()) {
+        return;
     }
-}
 
-void Osp::selectPrevTrack(bool skipInvalid, bool autoPlay) {
-    const auto skipSubTunes = mSettings->getBool(KEY_APP_SKIP_SUBTUNES, APP_SKIP_SUBTUNES_DEFAULT);
-    if (skipSubTunes || !mSoundEngine->prevTrack()) {
-        if (const auto prevFileName = getPrevFileName();
-            prevFileName.empty() == false) {
-        
-            if (!engineLoad(mFileManager->getCurrentPath(), prevFileName)) {
-                // Go until we found something to play
-                if (skipInvalid) {
-                    selectPrevTrack(skipInvalid, autoPlay);
-                }
-            } else if (autoPlay) {
-                mSoundEngine->play();
-            }
-        }
-        else {
-            mSoundEngine->stop();
+    // Go until we found something to play, each song is tried once. Repeat one
+    // would try the same song again, after a failure the queue moves on instead.
+    auto automaticMove = automatic;
+    for (size_t tries=0; tries<mPlayQueue.getSize() && mPlayQueue.next(automaticMove); tries++) {
+        if (playQueueEntry(autoPlay) || !skipInvalid) {
+            return;
         }
+        automaticMove = false;
     }
+    mSoundEngine->stop();
 }
 
-std::string Osp::getPrevFileName() const {
-    const auto items = mFileManager->getCurrentPathEntries();
-    const auto itemCount = items.size();
-    
-    // No item selected, return first file from the end if exists
-    if (mLastFileSelected.empty()) {
-        for (size_t i=itemCount-1; i>0; i--) {
-            const auto entry = items[i];
-            if (!entry.folder) {
-                return entry.name; 
-            }
-        }
-        return mLastFileSelected;
+void Osp::selectPrevTrack(bool skipInvalid, bool autoPlay) {
+    const auto skipSubTunes = mSettings->getBool(KEY_APP_SKIP_SUBTUNES, APP_SKIP_SUBTUNES_DEFAULT);
+    if (!skipSubTunes && mSoundEngine->prevTrack()) {
+        return;
     }
 
-    // Try to find the previous item
-    bool byPass = false;
-    for (size_t i=itemCount-1; i>1; i--) {
-        const auto entry = items[i];
-        if (entry.name == mLastFileSelected || byPass) {
-            const auto previous = items[i-1];
-            if (previous.folder) {
-                byPass = true;
-                continue;
-            }
-
-            return previous.name;
+    for (size_t tries=0; tries<mPlayQueue.getSize() && mPlayQueue.prev(); tries++) {
+        if (playQueueEntry(autoPlay) || !skipInvalid) {
+            return;
         }
     }
-
-    return "";
+    mSoundEngine->stop();
 }
 
-std::string Osp::getNextFileName() const {
-    const auto items = mFileManager->getCurrentPathEntries();
-    const auto itemCount = items.size();
-    
-    // No item selected, return first file item if exists
-    if (mLastFileSelected.empty()) {
-        for (size_t i=0; i<itemCount; i++) {
-            const auto entry = items[i];
-            if (!entry.folder) {
-                return entry.name;
-            }
-        }
-        return mLastFileSelected;
+bool Osp::playQueueEntry(bool autoPlay) {
+    PlayQueue::Entry entry;
+    if (!mPlayQueue.getCurrent(entry) || !engineLoad(entry)) {
+        return false;
     }
 
-
-    // Try to find the next item
-    bool byPass = false;
-    for (size_t i=0; i<itemCount-1; i++) {
-        const auto entry = items[i];
-        if (entry.name == mLastFileSelected || byPass) {
-            const auto next = items[i+1];
-            if (next.folder) {
-                byPass = true;
-                continue;
-            }
-
-            return next.name;
+    if (autoPlay) {
+        // Resumed where it was left, only once. Posted before playing so the start is
+        // dropped with the read ahead instead of being heard.
+        if (entry.position > 0) {
+            mSoundEngine->seek(entry.position);
+            mPlayQueue.setCurrentPosition(entry.trackNumber, 0);
         }
+
+        mSoundEngine->play();
     }
 
-    return "";
+    return true;
 }
 
 void Osp::handleExplorerItemClick(const FileSystem::Entry item, const std::filesystem::path currentExplorerPath) {
@@ -378,13 +415,68 @@ void Osp::handleExplorerItemClick(const FileSystem::Entry item, const std::files
         }
     } else {
         if (mLastFileSelected != item.name || sndState == SoundEngine::State::FINISHED) {
-            if (engineLoad(mFileManager->getCurrentPath(), item.name)) {
-                mSoundEngine->play();
+            const auto path = (currentExplorerPath / item.name).string();
+            if (!mPlayQueue.isEmpty() && !mPlayQueue.isFromFolder()) {
+                // A queue built song by song is kept, the song plays next in it
+                mPlayQueue.insertNext({
+                    .path = path,
+                    .trackNumber = 0,
+                    .position = 0
+                });
+                mPlayQueue.select(path);
+            } else {
+                // The folder becomes the queue, starting at the clicked song
+                std::vector<PlayQueue::Entry> entries;
+                size_t current = 0;
+                for (const auto& entry : *mFileManager->getCurrentPathEntries()) {
+                    if (!entry.folder) {
+                        if (entry.name == item.name) {
+                            current = entries.size();
+                        }
+                        entries.push_back({
+                            .path = (currentExplorerPath / entry.name).string(),
+                            .trackNumber = 0,
+                            .position = 0
+                        });
+                    }
+                }
+                mPlayQueue.assign(entries, current);
             }
+
+            playQueueEntry(true);
         }
     }
 }
 
+void Osp::handleSearchChange(const std::string& query) {
+    // The previous results stay until the worker publishes the new ones
+    mLibraryIndexer->search(query, MAX_SEARCH_RESULTS);
+}
+
+void Osp::handleSearchResultClick(const LibraryIndexer::Record& record) {
+    mPlayQueue.append({
+        .path = record.path,
+        .trackNumber = 0,
+        .position = 0
+    });
+    mPlayQueue.select(record.path);
+    playQueueEntry(true);
+}
+
+void Osp::handleEnqueue(const std::string& path) {
+    const auto wasEmpty = mPlayQueue.isEmpty();
+    mPlayQueue.append({
+        .path = path,
+        .trackNumber = 0,
+        .position = 0
+    });
+
+    // The song after the playing one may have changed
+    if (!wasEmpty && mSoundEngine->getState() == SoundEngine::State::STARTED) {
+        enginePreloadNext();
+    }
+}
+
 void Osp::handlePlayerButtonClick(const PlayerFrame::ButtonId button) {
     const auto sndState = mSoundEngine->getState();
 
@@ -398,11 +490,7 @@ void Osp::handlePlayerButtonClick(const PlayerFrame::ButtonId button) {
                     mSoundEngine->play();
                     break;
                 case SoundEngine::State::FINISHED:
-                    if (! mLastFileSelected.empty()) {
-                        if (engineLoad(mFileManager->getCurrentPath(), mLastFileSelected)) {
-                            mSoundEngine->play();
-                        }
-                    }
+                    playQueueEntry(true);
                     break;
                 default:
                     break;
@@ -426,7 +514,7 @@ void Osp::handlePlayerButtonClick(const PlayerFrame::ButtonId button) {
                 case SoundEngine::State::ERROR: {
                     const auto skipUnsupportedTunes = mSettings->getBool(KEY_APP_SKIP_UNSUPPORTED_TUNES, APP_SKIP_UNSUPPORTED_TUNES_DEFAULT);
                     selectNextTrack(skipUnsupportedTunes,
-                        sndState != SoundEngine::State::FINISHED && sndState != SoundEngine::State::ERROR);
+                        sndState != SoundEngine::State::FINISHED && sndState != SoundEngine::State::ERROR, false);
                     }
                     break;
                 default:
@@ -482,6 +570,19 @@ void Osp::handleAppSettingsChange(const SettingsWindow::AppSetting setting, bool
             mSettings->putBool(KEY_APP_ALWAYS_START_FIRST_TUNE, value);
             break;
         }
+        case SettingsWindow::AppSetting::LOUDNESS_NORMALIZATION: {
+            mSettings->putBool(KEY_APP_LOUDNESS_NORMALIZATION, value);
+            mSoundEngine->setLoudnessNormalization(value);
+            break;
+        }
+        case SettingsWindow::AppSetting::LOW_LATENCY: {
+            mSettings->putBool(KEY_APP_LOW_LATENCY, value);
+            break;
+        }
+        case SettingsWindow::AppSetting::LIBRARY_INDEXING: {
+            mSettings->putBool(KEY_APP_LIBRARY_INDEXING, value);
+            break;
+        }
     }
     mSettings->save(CONFIG_FILENAME);
 }
@@ -521,6 +622,25 @@ void Osp::handleMenuBarAction(const MenuBar::ItemId action) {
         case MenuBar::ItemId::SHOW_METRICS:
             mMetricsWindow.setVisible(true);
             break;
+        case MenuBar::ItemId::TOGGLE_SHUFFLE:
+            mPlayQueue.setShuffle(!mPlayQueue.isShuffled());
+            enginePreloadNext();
+            break;
+        case MenuBar::ItemId::REPEAT_OFF:
+            mPlayQueue.setRepeat(PlayQueue::REPEAT_OFF);
+            enginePreloadNext();
+            break;
+        case MenuBar::ItemId::REPEAT_ALL:
+            mPlayQueue.setRepeat(PlayQueue::REPEAT_ALL);
+            enginePreloadNext();
+            break;
+        case MenuBar::ItemId::REPEAT_ONE:
+            mPlayQueue.setRepeat(PlayQueue::REPEAT_ONE);
+            enginePreloadNext();
+            break;
+        case MenuBar::ItemId::CLEAR_QUEUE:
+            mPlayQueue.clear();
+            break;
         case MenuBar::ItemId::QUIT:
             SDL_Event event;
             event.type = SDL_QUIT;
@@ -529,14 +649,48 @@ void Osp::handleMenuBarAction(const MenuBar::ItemId action) {
     }
 }
 
-bool Osp::engineLoad(std::string path, std::string filename) {
-    const auto file = mFileManager->getFile(path.append("/").append(filename));
-    
-    mLastFileSelected = filename;
-    if (! mSoundEngine->load(file, mSettings)) {
+bool Osp::engineLoad(const PlayQueue::Entry& entry) {
+    const auto file = mFileManager->getFile(entry.path);
+
+    mLastFileSelected = std::filesystem::path(entry.path).filename().string();
+    if (file == nullptr || !mSoundEngine->load(file, mSettings, entry.trackNumber)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", mSoundEngine->getError().c_str());
         return false;
     }
 
+    enginePreloadNext();
     return true;
 }
+
+void Osp::analyzeBrowsedFolder() {
+    // Measure in background the songs of the folder just opened
+    mLoudnessBrowsedPath = mFileManager->getCurrentPath();
+    mLoudnessBrowsedGeneration = mFileManager->getListingGeneration();
+
+    std::vector<std::shared_ptr<File>> files;
+    for (const auto& entry : *mFileManager->getCurrentPathEntries()) {
+        if (!entry.folder) {
+            auto path = mLoudnessBrowsedPath.string();
+            if (const auto file = mFileManager->getFile(path.append("/").append(entry.name));
+                file != nullptr) {
+
+                files.push_back(file);
+            }
+        }
+    }
+
+    mSoundEngine->analyzeLoudness(files);
+}
+
+void Osp::enginePreloadNext() {
+    // Let the engine prepare the next song to play it without gap
+    if (PlayQueue::Entry entry;
+        mPlayQueue.peekNext(true, entry)) {
+
+        if (const auto file = mFileManager->getFile(entry.path);
+            file != nullptr) {
+
+            mSoundEngine->preload(file, mSettings, entry.trackNumber);
+        }
+    }
+}
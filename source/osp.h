@@ -12,6 +12,8 @@
 #include "ui/frame/menubar.h"
 #include "spritecatalog.h"
 #include "filemanager.h"
+#include "libraryindexer.h"
+#include "playqueue.h"
 #include "settings.h"
 #include "soundengine.h"
 
@@ -23,6 +25,11 @@ class Osp {
 
     public:
         const std::string CONFIG_FILENAME = "config.cfg";
+        const std::string LOUDNESS_CACHE_FILENAME = "loudness.cache";
+        const std::string AUDIO_METRICS_FILENAME = "audio-metrics.txt";
+        const std::string LIBRARY_INDEX_FILENAME = "library.index";
+        const std::string PLAY_QUEUE_FILENAME = "queue.txt";
+        const size_t MAX_SEARCH_RESULTS = 500;
 
         Osp();
         virtual ~Osp();
@@ -36,10 +43,16 @@ class Osp {
         GLuint mTextureSprites;
         std::string mStatusMessage;
         std::string mLastFileSelected;
+        std::filesystem::path mLoudnessBrowsedPath;
+        Uint32 mLoudnessBrowsedGeneration;
+        Uint32 mSearchGeneration;
+        std::shared_ptr<const std::vector<LibraryIndexer::Record>> mSearchResults;
         std::shared_ptr<Settings> mSettings;
         std::shared_ptr<SpriteCatalog> mSpriteCatalog;
         std::unique_ptr<FileManager> mFileManager;
         std::unique_ptr<SoundEngine> mSoundEngine;
+        std::unique_ptr<LibraryIndexer> mLibraryIndexer;
+        PlayQueue mPlayQueue;
 
         MenuBar mMenuBar;
         ExplorerFrame mExplorerFrame;
@@ -52,14 +65,18 @@ class Osp {
 
         Osp(const Osp& copy);
 
-        void selectNextTrack(bool skipInvalid, bool autoPlay);
+        void selectNextTrack(bool skipInvalid, bool autoPlay, bool automatic);
         void selectPrevTrack(bool skipInvalid, bool autoPlay);
-        std::string getPrevFileName() const;
-        std::string getNextFileName() const;
-        bool engineLoad(std::string path, std::string filename);
+        bool playQueueEntry(bool autoPlay);
+        bool engineLoad(const PlayQueue::Entry& entry);
+        void enginePreloadNext();
+        void analyzeBrowsedFolder();
         
         void handlePlayerButtonClick(const PlayerFrame::ButtonId button);
         void handleExplorerItemClick(const FileSystem::Entry item, const std::filesystem::path currentExplorerPath);
+        void handleSearchChange(const std::string& query);
+        void handleSearchResultClick(const LibraryIndexer::Record& record);
+        void handleEnqueue(const std::string& path);
         void handleAppSettingsChange(const SettingsWindow::AppSetting setting, bool value);
         void handleStyleChange(int style);
         void handleFontChange(ImFont* font, int fontIndex);
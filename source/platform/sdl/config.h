@@ -1,3 +1,4 @@
 #define DATA_PATH "./romfs"
 #define DEFAULT_LOCAL_FS_PATH "/"
 #define PLATFORM_HAS_MOUSE_CURSOR true
+#define PLATFORM_HAS_MMAP true
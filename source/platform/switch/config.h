@@ -1,3 +1,4 @@
 #define DATA_PATH "romfs:"
 #define DEFAULT_LOCAL_FS_PATH "sdmc:/"
 #define PLATFORM_HAS_MOUSE_CURSOR false
+#define PLATFORM_HAS_MMAP false
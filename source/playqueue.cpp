@@ -0,0 +1,291 @@
+#include "playqueue.h"
+
+#include <fstream>
+#include <sstream>
+
+// Older queues are dropped
+const int PlayQueue::FILE_VERSION = 1;
+
+PlayQueue::PlayQueue() :
+    mCurrent(0),
+    mFromFolder(false),
+    mShuffle(false),
+    mRepeat(REPEAT_OFF),
+    mRandom(std::random_device()()) {
+}
+
+PlayQueue::~PlayQueue() {
+}
+
+void PlayQueue::clear() {
+    mEntries.clear();
+    mOrder.clear();
+    mOrderPositions.clear();
+    mPathIndexes.clear();
+    mCurrent = 0;
+    mFromFolder = false;
+}
+
+void PlayQueue::assign(const std::vector<Entry>& entries, const size_t current) {
+    clear();
+    for (const auto& entry : entries) {
+        if (mPathIndexes.emplace(entry.path, (Uint32) mEntries.size()).second) {
+            mEntries.push_back(entry);
+        }
+    }
+
+    if (current < entries.size()) {
+        buildOrder(mPathIndexes[entries[current].path]);
+        select(entries[current].path);
+    }
+    mFromFolder = true;
+}
+
+void PlayQueue::append(const Entry& entry) {
+    if (mPathIndexes.count(entry.path) > 0) {
+        select(entry.path);
+        return;
+    }
+
+    // Queued after everything else, even shuffled
+    const auto index = (Uint32) mEntries.size();
+    mPathIndexes[entry.path] = index;
+    mEntries.push_back(entry);
+    mOrderPositions.push_back(mOrder.size());
+    mOrder.push_back(index);
+    mFromFolder = false;
+}
+
+void PlayQueue::insertNext(const Entry& entry) {
+    mFromFolder = false;
+    if (mPathIndexes.count(entry.path) > 0) {
+        return;
+    }
+
+    const auto index = (Uint32) mEntries.size();
+    const auto position = mOrder.empty() ? 0 : mCurrent + 1;
+    mPathIndexes[entry.path] = index;
+    mEntries.push_back(entry);
+    mOrder.insert(mOrder.begin() + position, index);
+
+    // The songs after it move one place
+    mOrderPositions.push_back(position);
+    for (auto i=position + 1; i<mOrder.size(); i++) {
+        mOrderPositions[mOrder[i]] = i;
+    }
+}
+
+bool PlayQueue::select(const std::string& path) {
+    const auto index = mPathIndexes.find(path);
+    if (index == mPathIndexes.end()) {
+        return false;
+    }
+
+    mCurrent = mOrderPositions[index->second];
+    return true;
+}
+
+bool PlayQueue::isEmpty() const {
+    return mEntries.empty();
+}
+
+bool PlayQueue::isFromFolder() const {
+    return mFromFolder;
+}
+
+size_t PlayQueue::getSize() const {
+    return mEntries.size();
+}
+
+bool PlayQueue::getCurrent(Entry& entry) const {
+    if (mEntries.empty()) {
+        return false;
+    }
+
+    entry = mEntries[mOrder[mCurrent]];
+    return true;
+}
+
+void PlayQueue::setCurrentPosition(const int trackNumber, const int position) {
+    if (!mEntries.empty()) {
+        auto& entry = mEntries[mOrder[mCurrent]];
+        entry.trackNumber = trackNumber;
+        entry.position = position;
+    }
+}
+
+bool PlayQueue::peekNext(const bool automatic, Entry& entry) const {
+    const auto position = getNextOrderPosition(automatic);
+    if (position < 0) {
+        return false;
+    }
+
+    entry = mEntries[mOrder[position]];
+    return true;
+}
+
+bool PlayQueue::next(const bool automatic) {
+    const auto position = getNextOrderPosition(automatic);
+    if (position < 0) {
+        return false;
+    }
+
+    mCurrent = position;
+    return true;
+}
+
+bool PlayQueue::prev() {
+    if (mEntries.empty()) {
+        return false;
+    }
+
+    if (mCurrent > 0) {
+        mCurrent--;
+        return true;
+    }
+
+    if (mRepeat == REPEAT_ALL) {
+        mCurrent = mOrder.size() - 1;
+        return true;
+    }
+
+    return false;
+}
+
+void PlayQueue::setShuffle(const bool shuffle) {
+    if (shuffle == mShuffle) {
+        return;
+    }
+
+    // The playing song stays current, at the start of the new order
+    if (mEntries.empty()) {
+        mShuffle = shuffle;
+        return;
+    }
+
+    const auto current = mOrder[mCurrent];
+    mShuffle = shuffle;
+    buildOrder(current);
+    mCurrent = mOrderPositions[current];
+}
+
+bool PlayQueue::isShuffled() const {
+    return mShuffle;
+}
+
+void PlayQueue::setRepeat(const Repeat repeat) {
+    mRepeat = repeat;
+}
+
+PlayQueue::Repeat PlayQueue::getRepeat() const {
+    return mRepeat;
+}
+
+bool PlayQueue::load(const std::filesystem::path path) {
+    std::ifstream is(path);
+    std::string line;
+    if (!is.good() || !std::getline(is, line) || line != std::string("osp-queue ").append(std::to_string(FILE_VERSION))) {
+        return false;
+    }
+
+    // shuffle repeat current fromFolder, then the play order, then trackNumber position path per entry
+    int shuffle = 0, repeat = 0, fromFolder = 0;
+    size_t current = 0;
+    std::string orderLine;
+    if (!std::getline(is, line)) {
+        return false;
+    }
+    std::istringstream state(line);
+    if (!(state >> shuffle >> repeat >> current) || !std::getline(is, orderLine)) {
+        return false;
+    }
+    // Missing from the queues saved before it
+    state >> fromFolder;
+
+    clear();
+    while (std::getline(is, line)) {
+        std::istringstream fields(line);
+        std::string trackNumber, position;
+        Entry entry;
+        if (std::getline(fields, trackNumber, '\t') && std::getline(fields, position, '\t') && std::getline(fields, entry.path) &&
+            mPathIndexes.emplace(entry.path, (Uint32) mEntries.size()).second) {
+
+            entry.trackNumber = std::atoi(trackNumber.c_str());
+            entry.position = std::atoi(position.c_str());
+            mEntries.push_back(entry);
+        }
+    }
+
+    mShuffle = shuffle != 0;
+    mFromFolder = fromFolder != 0;
+    mRepeat = repeat >= REPEAT_OFF && repeat <= REPEAT_ONE ? (Repeat) repeat : REPEAT_OFF;
+
+    // A damaged order is rebuilt
+    std::istringstream order(orderLine);
+    mOrderPositions.assign(mEntries.size(), mEntries.size());
+    for (Uint32 index; order >> index && index < mEntries.size() && mOrderPositions[index] == mEntries.size();) {
+        mOrderPositions[index] = mOrder.size();
+        mOrder.push_back(index);
+    }
+    if (mOrder.size() != mEntries.size()) {
+        buildOrder(0);
+    }
+
+    mCurrent = current < mOrder.size() ? current : 0;
+    return true;
+}
+
+bool PlayQueue::save(const std::filesystem::path path) const {
+    std::ofstream os(path, std::ios::trunc);
+    if (!os.good()) {
+        return false;
+    }
+
+    os << "osp-queue " << FILE_VERSION << "\n";
+    os << (mShuffle ? 1 : 0) << " " << (int) mRepeat << " " << mCurrent << " " << (mFromFolder ? 1 : 0) << "\n";
+    for (size_t i=0; i<mOrder.size(); i++) {
+        os << (i > 0 ? " " : "") << mOrder[i];
+    }
+    os << "\n";
+    for (const auto& entry : mEntries) {
+        os << entry.trackNumber << "\t" << entry.position << "\t" << entry.path << "\n";
+    }
+
+    return os.good();
+}
+
+int PlayQueue::getNextOrderPosition(const bool automatic) const {
+    if (mEntries.empty()) {
+        return -1;
+    }
+
+    if (automatic && mRepeat == REPEAT_ONE) {
+        return mCurrent;
+    }
+
+    if (mCurrent + 1 < mOrder.size()) {
+        return mCurrent + 1;
+    }
+
+    return mRepeat == REPEAT_ALL ? 0 : -1;
+}
+
+void PlayQueue::buildOrder(const Uint32 first) {
+    mOrder.resize(mEntries.size());
+    for (size_t i=0; i<mOrder.size(); i++) {
+        mOrder[i] = i;
+    }
+
+    // Fisher-Yates on everything but the first song
+    if (mShuffle && first < mOrder.size()) {
+        std::swap(mOrder[0], mOrder[first]);
+        for (size_t i=mOrder.size(); i>2; i--) {
+            std::swap(mOrder[i - 1], mOrder[std::uniform_int_distribution<size_t>(1, i - 1)(mRandom)]);
+        }
+    }
+
+    mOrderPositions.resize(mOrder.size());
+    for (size_t i=0; i<mOrder.size(); i++) {
+        mOrderPositions[mOrder[i]] = i;
+    }
+}
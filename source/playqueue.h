@@ -0,0 +1,82 @@
+#pragma once
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL2/SDL_stdinc.h>
+
+// Songs to play, from any folder, in their order or shuffled. The play order
+// is a permutation of the entries so moving in it, looking ahead for the
+// preload or finding a song by its path are all constant time.
+class PlayQueue {
+
+    public:
+        enum Repeat {
+            REPEAT_OFF,
+            REPEAT_ALL,
+            REPEAT_ONE
+        };
+
+        struct Entry {
+            std::string path;
+            // 0 for the sub tune chosen by the decoder
+            int trackNumber;
+            // Start offset in seconds
+            int position;
+        };
+
+        PlayQueue();
+        virtual ~PlayQueue();
+
+        void clear();
+        // The songs of a folder, replaced as a whole by the next folder played
+        void assign(const std::vector<Entry>& entries, const size_t current);
+        // Already queued songs are only selected
+        void append(const Entry& entry);
+        // Right after the current song, already queued songs stay where they are
+        void insertNext(const Entry& entry);
+        bool select(const std::string& path);
+
+        bool isEmpty() const;
+        // False once songs were added one by one
+        bool isFromFolder() const;
+        size_t getSize() const;
+        bool getCurrent(Entry& entry) const;
+        void setCurrentPosition(const int trackNumber, const int position);
+
+        // Automatic moves follow repeat one, the ones asked by the user don't
+        bool peekNext(const bool automatic, Entry& entry) const;
+        bool next(const bool automatic);
+        bool prev();
+
+        void setShuffle(const bool shuffle);
+        bool isShuffled() const;
+        void setRepeat(const Repeat repeat);
+        Repeat getRepeat() const;
+
+        bool load(const std::filesystem::path path);
+        bool save(const std::filesystem::path path) const;
+
+    private:
+        static const int FILE_VERSION;
+
+        std::vector<Entry> mEntries;
+        // Play order, as entry indexes, and the place of each entry in it
+        std::vector<Uint32> mOrder;
+        std::vector<Uint32> mOrderPositions;
+        std::unordered_map<std::string, Uint32> mPathIndexes;
+        size_t mCurrent;
+        bool mFromFolder;
+        bool mShuffle;
+        Repeat mRepeat;
+        std::mt19937 mRandom;
+
+        PlayQueue(const PlayQueue& copy);
+
+        int getNextOrderPosition(const bool automatic) const;
+        // Shuffled, first is played first
+        void buildOrder(const Uint32 first);
+
+};
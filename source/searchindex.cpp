@@ -0,0 +1,219 @@
+#include "searchindex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+const Uint32 SearchIndex::MAGIC = 0x5350534f; // "OSPS"
+const Uint32 SearchIndex::VERSION = 1;
+// 1 MB of offsets, few enough collisions for a few hundred thousand songs
+const Uint32 SearchIndex::BUCKET_BITS = 18;
+// Magic, version, checksum on two words, record count, posting count
+const size_t SearchIndex::HEADER_SIZE = 6;
+
+SearchIndex::SearchIndex(const LibraryIndexer::Records records) :
+    mRecords(records),
+    mChecksum(getChecksum(*records)),
+    mOffsets(nullptr),
+    mPostings(nullptr) {
+
+    // Built once, queries then run without allocating
+    mTextOffsets.reserve(records->size() + 1);
+    for (const auto& record : *records) {
+        mTextOffsets.push_back(mText.size());
+        appendText(record, mText);
+    }
+    mTextOffsets.push_back(mText.size());
+}
+
+SearchIndex::~SearchIndex() {
+}
+
+void SearchIndex::build() {
+    const auto bucketCount = (size_t) 1 << BUCKET_BITS;
+    mContent = nullptr;
+    mStorage.assign(HEADER_SIZE + bucketCount + 1, 0);
+    mStorage[0] = MAGIC;
+    mStorage[1] = VERSION;
+    mStorage[2] = (Uint32) mChecksum;
+    mStorage[3] = (Uint32) (mChecksum >> 32);
+    mStorage[4] = mRecords->size();
+
+    // Count first so the postings are allocated once
+    const auto offsets = mStorage.data() + HEADER_SIZE;
+    std::vector<Uint32> buckets;
+    for (size_t position=0; position<mRecords->size(); position++) {
+        getBuckets(getText(position), buckets);
+        for (const auto bucket : buckets) {
+            offsets[bucket + 1]++;
+        }
+    }
+    for (size_t bucket=0; bucket<bucketCount; bucket++) {
+        offsets[bucket + 1] += offsets[bucket];
+    }
+
+    const auto postingCount = offsets[bucketCount];
+    mStorage[5] = postingCount;
+    mStorage.resize(mStorage.size() + postingCount);
+
+    // Songs are added in order, each bucket ends up sorted
+    std::vector<Uint32> cursors(mStorage.begin() + HEADER_SIZE, mStorage.begin() + HEADER_SIZE + bucketCount);
+    const auto postings = mStorage.data() + HEADER_SIZE + bucketCount + 1;
+    for (size_t position=0; position<mRecords->size(); position++) {
+        getBuckets(getText(position), buckets);
+        for (const auto bucket : buckets) {
+            postings[cursors[bucket]++] = position;
+        }
+    }
+
+    attach(mStorage.data(), mStorage.size());
+}
+
+bool SearchIndex::load(const std::filesystem::path path) {
+    auto content = std::unique_ptr<FileContent>(new FileContent());
+    if (!content->map(path)) {
+        return false;
+    }
+
+    const auto view = content->getView();
+    if (view.size % sizeof(Uint32) != 0 || !attach((const Uint32*) view.data, view.size / sizeof(Uint32))) {
+        return false;
+    }
+
+    mStorage.clear();
+    mContent = std::move(content);
+    return true;
+}
+
+bool SearchIndex::save(const std::filesystem::path path) const {
+    if (mStorage.empty()) {
+        return false;
+    }
+
+    // Written aside then renamed, the previous index may still be mapped
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    std::ofstream os(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    os.write((const char*) mStorage.data(), mStorage.size() * sizeof(Uint32));
+    os.close();
+
+    std::error_code errorCode;
+    std::filesystem::rename(tempPath, path, errorCode);
+    return !os.fail() && !errorCode;
+}
+
+void SearchIndex::find(const std::string& query, const size_t maxResults,
+    std::vector<LibraryIndexer::Record>& results) const {
+
+    results.clear();
+    auto text = query;
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    if (text.empty() || mOffsets == nullptr) {
+        return;
+    }
+
+    // Too short for a trigram, they match so many songs that the scan stops early
+    if (text.size() < 3) {
+        for (size_t position=0; position<mRecords->size() && results.size() < maxResults; position++) {
+            if (matches(position, text)) {
+                results.push_back((*mRecords)[position]);
+            }
+        }
+        return;
+    }
+
+    // Walk the smallest bucket, look the candidates up in the others
+    std::vector<Uint32> buckets;
+    getBuckets(text, buckets);
+    std::sort(buckets.begin(), buckets.end(), [this](const Uint32 a, const Uint32 b) {
+        return mOffsets[a + 1] - mOffsets[a] < mOffsets[b + 1] - mOffsets[b];
+    });
+
+    const auto smallest = buckets.front();
+    for (auto posting = mPostings + mOffsets[smallest]; posting != mPostings + mOffsets[smallest + 1] && results.size() < maxResults; posting++) {
+        const auto position = *posting;
+        const auto inAll = std::all_of(buckets.begin() + 1, buckets.end(), [this, position](const Uint32 bucket) {
+            return std::binary_search(mPostings + mOffsets[bucket], mPostings + mOffsets[bucket + 1], position);
+        });
+
+        // Buckets are shared by several trigrams, the text has the last word
+        if (inAll && matches(position, text)) {
+            results.push_back((*mRecords)[position]);
+        }
+    }
+}
+
+bool SearchIndex::attach(const Uint32* data, const size_t size) {
+    const auto bucketCount = (size_t) 1 << BUCKET_BITS;
+    if (size < HEADER_SIZE + bucketCount + 1 ||
+        data[0] != MAGIC || data[1] != VERSION ||
+        data[2] != (Uint32) mChecksum || data[3] != (Uint32) (mChecksum >> 32) ||
+        data[4] != mRecords->size() ||
+        size != HEADER_SIZE + bucketCount + 1 + data[5] ||
+        data[HEADER_SIZE + bucketCount] != data[5]) {
+
+        return false;
+    }
+
+    // A damaged file would make find() read outside the postings or the records
+    const auto offsets = data + HEADER_SIZE;
+    const auto postings = data + HEADER_SIZE + bucketCount + 1;
+    for (size_t bucket=0; bucket<bucketCount; bucket++) {
+        if (offsets[bucket] > offsets[bucket + 1]) {
+            return false;
+        }
+    }
+    if (std::any_of(postings, postings + data[5], [this](const Uint32 position) { return position >= mRecords->size(); })) {
+        return false;
+    }
+
+    mOffsets = offsets;
+    mPostings = postings;
+    return true;
+}
+
+std::string_view SearchIndex::getText(const size_t position) const {
+    return std::string_view(mText).substr(mTextOffsets[position], mTextOffsets[position + 1] - mTextOffsets[position]);
+}
+
+bool SearchIndex::matches(const size_t position, const std::string& query) const {
+    return getText(position).find(query) != std::string_view::npos;
+}
+
+// Hash of the songs and the texts indexed
+uint64_t SearchIndex::getChecksum(const std::vector<LibraryIndexer::Record>& records) {
+    auto hash = FileView().getHash();
+    const auto add = [&hash](const void* data, const size_t size) {
+        hash = FileView{ (const char*) data, size }.getHash(hash);
+    };
+
+    for (const auto& record : records) {
+        add(record.path.data(), record.path.size() + 1);
+        add(&record.size, sizeof(record.size));
+        add(&record.modified, sizeof(record.modified));
+        add(record.title.data(), record.title.size() + 1);
+        add(record.author.data(), record.author.size() + 1);
+    }
+    return hash;
+}
+
+void SearchIndex::appendText(const LibraryIndexer::Record& record, std::string& text) {
+    // The separators never appear in a query, no match across fields
+    const auto start = text.size();
+    const auto slash = record.path.rfind('/');
+    text.append(record.path, slash == std::string::npos ? 0 : slash + 1, std::string::npos);
+    text.append("\n").append(record.title).append("\n").append(record.author);
+    std::transform(text.begin() + start, text.end(), text.begin() + start, ::tolower);
+}
+
+void SearchIndex::getBuckets(const std::string_view text, std::vector<Uint32>& buckets) {
+    buckets.clear();
+    for (size_t i=0; i+2<text.size(); i++) {
+        const auto trigram = (Uint32) (Uint8) text[i] << 16 | (Uint32) (Uint8) text[i + 1] << 8 | (Uint8) text[i + 2];
+        buckets.push_back((trigram * 2654435761u) >> (32 - BUCKET_BITS));
+    }
+
+    std::sort(buckets.begin(), buckets.end());
+    buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+}
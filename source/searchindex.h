@@ -0,0 +1,63 @@
+#pragma once
+
+#include "libraryindexer.h"
+#include "filesystem/filecontent.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <SDL2/SDL_stdinc.h>
+
+// Trigram index over the file name, title and author of the library songs.
+// Trigrams are hashed in a fixed number of buckets, each holding the sorted
+// positions of the songs containing one of its trigrams. A query intersects
+// the buckets of its trigrams then checks the few candidates left against the
+// lowercased texts, kept end to end in a single string.
+// Saved next to the library index and memory mapped back while it matches it.
+class SearchIndex {
+
+    public:
+        SearchIndex(const LibraryIndexer::Records records);
+        virtual ~SearchIndex();
+
+        void build();
+        // False if missing, damaged or built for other records
+        bool load(const std::filesystem::path path);
+        bool save(const std::filesystem::path path) const;
+
+        // Songs containing the query, case insensitive
+        void find(const std::string& query, const size_t maxResults,
+            std::vector<LibraryIndexer::Record>& results) const;
+
+    private:
+        static const Uint32 MAGIC;
+        static const Uint32 VERSION;
+        static const Uint32 BUCKET_BITS;
+        static const size_t HEADER_SIZE;
+
+        const LibraryIndexer::Records mRecords;
+        const uint64_t mChecksum;
+
+        // Lowercased text of each song, from mTextOffsets[position] to the next offset
+        std::string mText;
+        std::vector<Uint32> mTextOffsets;
+
+        // Header, one offset per bucket plus the end, then the postings
+        std::vector<Uint32> mStorage;
+        std::unique_ptr<FileContent> mContent;
+        const Uint32* mOffsets;
+        const Uint32* mPostings;
+
+        SearchIndex(const SearchIndex& copy);
+
+        bool attach(const Uint32* data, const size_t size);
+        std::string_view getText(const size_t position) const;
+        bool matches(const size_t position, const std::string& query) const;
+
+        static uint64_t getChecksum(const std::vector<LibraryIndexer::Record>& records);
+        static void appendText(const LibraryIndexer::Record& record, std::string& text);
+        static void getBuckets(const std::string_view text, std::vector<Uint32>& buckets);
+
+};
@@ -1,17 +1,80 @@
 #include "soundengine.h"
 
-#include "decoder/dumb/dumbdecoder.h"
-#include "decoder/gme/gmedecoder.h"
-#include "decoder/sc68/sc68decoder.h"
-#include "decoder/sidplayfp/sidplaydecoder.h"
+#include "decoder/decoderfactory.h"
+#include "audio/samplekernels.h"
 #include "strings.h"
+#include "app_settings_strings.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <SDL2/SDL_log.h>
+#include <SDL2/SDL_timer.h>
+
+// Read ahead values selectable in the settings
+static const int READ_AHEAD_MS[] = { 100, 200, 500, 1000 };
+static const int READ_AHEAD_COUNT = sizeof(READ_AHEAD_MS) / sizeof(READ_AHEAD_MS[0]);
+
+// Device buffer in frames, the low latency mode compensate a small one with an adaptive read ahead
+static const int DEVICE_BUFFER_FRAMES = 2048;
+static const int LOW_LATENCY_DEVICE_BUFFER_FRAMES = 256;
+static const Uint32 READ_AHEAD_SHRINK_DELAY_MS = 10000;
+static const Uint32 COMMAND_LATENCY_TIMEOUT_MS = 5000;
+
+// Crossfade durations selectable in the settings
+static const int CROSSFADE_MS[] = { 0, 1000, 2000, 5000 };
+static const int CROSSFADE_COUNT = sizeof(CROSSFADE_MS) / sizeof(CROSSFADE_MS[0]);
+
+static const float HALF_PI = 1.57079632679f;
+
+static void convertToFloat(const Uint8* input, const SDL_AudioFormat format, float* output, const size_t count) {
+    if (format == AUDIO_F32SYS) {
+        memcpy(output, input, count * sizeof(float));
+    } else {
+        SampleKernels::convertS16ToFloat((const Sint16*) input, output, count);
+    }
+}
 
 SoundEngine::SoundEngine() :
+    mEmptyMetaData(std::make_shared<const Decoder::MetaData>()),
     mStateMutex(SDL_CreateMutex()),
-    mCurrentDecoder(nullptr) {
+    mDecoderThread(nullptr),
+    mDecoderMutex(SDL_CreateMutex()),
+    mLifecycleMutex(SDL_CreateMutex()),
+    mDecoderCond(SDL_CreateCond()),
+    mDecoderThreadRunning(false),
+    mDecoderEnded(true),
+    mLowLatency(false),
+    mReadAheadTarget(0),
+    mLastUnderruns(0),
+    mLastAdaptTicks(0),
+    mCommandTime(0),
+    mPendingTrack(0),
+    mPendingSeek(-1),
+    mNormalizeLoudness(APP_LOUDNESS_NORMALIZATION_DEFAULT),
+    mCurrentHash(0),
+    mTrackGainDb(0.0f),
+    mNextHash(0),
+    mActiveDecoderList(0),
+    mNextDecoderList(-1),
+    mCommandDecoderList(-1),
+    mCurrentDecoder(nullptr),
+    mNextDecoder(nullptr),
+    mSkipSubTunes(false),
+    mCrossfadeMs(CROSSFADE_MS[APP_CROSSFADE_DEFAULT]),
+    mFadingDecoder(nullptr),
+    mFadingDecoderList(-1),
+    mFadeFrames(0),
+    mFadePosition(0),
+    mFadingGainDb(0.0f),
+    mTrackFrames(0),
+    mCurrentDuration(0),
+    mMetaData(mEmptyMetaData),
+    mPublishedPath(std::make_shared<const std::filesystem::path>()),
+    mPublishedTrackNumber(0),
+    mPosition(-1),
+    mPreloadThread(nullptr),
+    mPreloadTrackNumber(0) {
 }
 
 SoundEngine::~SoundEngine() {
@@ -19,6 +82,21 @@ SoundEngine::~SoundEngine() {
         SDL_DestroyMutex(mStateMutex);
         mStateMutex = nullptr;
     }
+
+    if (mDecoderMutex != nullptr) {
+        SDL_DestroyMutex(mDecoderMutex);
+        mDecoderMutex = nullptr;
+    }
+
+    if (mLifecycleMutex != nullptr) {
+        SDL_DestroyMutex(mLifecycleMutex);
+        mLifecycleMutex = nullptr;
+    }
+
+    if (mDecoderCond != nullptr) {
+        SDL_DestroyCond(mDecoderCond);
+        mDecoderCond = nullptr;
+    }
 }
 
 SoundEngine::State SoundEngine::getState() const {
@@ -29,14 +107,34 @@ std::string SoundEngine::getError() const {
     return mError;
 }
 
-Decoder::MetaData SoundEngine::getMetaData() const {
-    // No need to check engine state, if current deocder is not null
-    // it can send us the meta data
-    if (mCurrentDecoder != nullptr && mState != ERROR) {
-        return mCurrentDecoder->getMetaData();
+std::shared_ptr<const Decoder::MetaData> SoundEngine::getMetaData() const {
+    if (mState == ERROR) {
+        return mEmptyMetaData;
     }
 
-    return mEmptyMetaData;
+    return std::atomic_load(&mMetaData);
+}
+
+int SoundEngine::getPosition() const {
+    return mState == ERROR ? -1 : mPosition.load();
+}
+
+std::filesystem::path SoundEngine::getCurrentPath() const {
+    return *std::atomic_load(&mPublishedPath);
+}
+
+AudioMetrics& SoundEngine::getMetrics() {
+    return mMetrics;
+}
+
+SDL_mutex* SoundEngine::getLifecycleMutex() const {
+    return mLifecycleMutex;
+}
+
+bool SoundEngine::isBusy() const {
+    // Against the target, the low latency mode fills much less than the capacity and the
+    // decoder stops a chunk short of the target. A song rendered to its end only drains.
+    return mState == STARTED && !mDecoderEnded && mRingBuffer.getAvailableRead() < mReadAheadTarget / 2;
 }
 
 void SoundEngine::clearError() {
@@ -46,20 +144,29 @@ void SoundEngine::clearError() {
     SDL_UnlockMutex(mStateMutex);
 }
 
-bool SoundEngine::setup(const std::filesystem::path dataPath) {
+bool SoundEngine::setup(const std::filesystem::path dataPath, const std::filesystem::path loudnessCachePath,
+    std::shared_ptr<Settings> settings, const bool lowLatency) {
+
     // Setup default sound output
     SDL_AudioSpec obtainedAudioSpec;
     SDL_AudioSpec wantedAudioSpec;
     wantedAudioSpec.callback = SoundEngine::audioCallback;
     wantedAudioSpec.userdata = this;
-    wantedAudioSpec.samples = 2048; // 2048 for better latency ?
+    wantedAudioSpec.samples = lowLatency ? LOW_LATENCY_DEVICE_BUFFER_FRAMES : DEVICE_BUFFER_FRAMES;
     wantedAudioSpec.channels = 2;
-    wantedAudioSpec.format = AUDIO_S16SYS;
-    wantedAudioSpec.freq = 48000;
+    wantedAudioSpec.format = AUDIO_F32SYS;
+    wantedAudioSpec.freq = Decoder::DEFAULT_AUDIO_FREQUENCY;
+
+    // Take the device frequency and format as is, we resample and convert ourself
+    mAudioDevice = SDL_OpenAudioDevice(nullptr, 0, &wantedAudioSpec, &obtainedAudioSpec,
+        SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_FORMAT_CHANGE);
+    if (mAudioDevice > 0 && !AudioPipeline::isFormatSupported(obtainedAudioSpec.format)) {
+        // Format we don't produce, let SDL convert from float
+        SDL_CloseAudioDevice(mAudioDevice);
+        mAudioDevice = SDL_OpenAudioDevice(nullptr, 0, &wantedAudioSpec, &obtainedAudioSpec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    }
 
-    // todo check if sdl will resample the data and warn user
-    if (mAudioDevice = SDL_OpenAudioDevice(nullptr, 0, &wantedAudioSpec, &obtainedAudioSpec, 0);
-        mAudioDevice < 0) {
+    if (mAudioDevice <= 0) {
 
         mState = ERROR;
         mError = std::string(STR_ERROR_OPEN_AUDIO_DEVICE " : ").append(SDL_GetError());
@@ -70,50 +177,107 @@ bool SoundEngine::setup(const std::filesystem::path dataPath) {
     mAudioChannels = obtainedAudioSpec.channels;
     mAudioFrequency = obtainedAudioSpec.freq;
     mAudioSampleFormat = obtainedAudioSpec.format;
-    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Audio current driver: %s, channels: %d, frequency: %d, sample format: 0x%X",
-        SDL_GetCurrentAudioDriver(), mAudioChannels, mAudioFrequency, mAudioSampleFormat);
-
-    // Instanciate all decoders
-    mDecoderList.push_back(std::shared_ptr<Decoder>(new DumbDecoder()));
-    mDecoderList.push_back(std::shared_ptr<Decoder>(new GmeDecoder()));
-    mDecoderList.push_back(std::shared_ptr<Decoder>(new Sc68Decoder()));
-    mDecoderList.push_back(std::shared_ptr<Decoder>(new SidPlayDecoder(std::string(dataPath).append("/c64roms"))));
+    mAudioBufferSize = obtainedAudioSpec.size;
+    mMetrics.setCallbackPeriod(obtainedAudioSpec.samples, mAudioFrequency);
+    mLowLatency = lowLatency;
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Audio current driver: %s, channels: %d, frequency: %d, sample format: 0x%X, buffer: %d frames%s",
+        SDL_GetCurrentAudioDriver(), mAudioChannels, mAudioFrequency, mAudioSampleFormat, obtainedAudioSpec.samples,
+        mLowLatency ? " (low latency)" : "");
+
+    // Render about one device buffer at a time in the decoder thread
+    mDecoderBuffer.resize(mAudioBufferSize);
+    mPipeline.setup(AUDIO_S16SYS, mAudioChannels, mAudioFrequency, mAudioSampleFormat, mAudioChannels, mAudioFrequency);
+    setReadAhead(READ_AHEAD_MS[APP_READ_AHEAD_DEFAULT]);
+
+    mDecoderThreadRunning = true;
+    if (mDecoderThread = SDL_CreateThread(SoundEngine::decoderThreadFunc, "OSP-Decoder-Thread", this);
+        mDecoderThread == nullptr) {
+
+        mDecoderThreadRunning = false;
+        mState = ERROR;
+        mError = std::string(STR_ERROR_DECODER_THREAD_START " : ").append(SDL_GetError());
+
+        return false;
+    }
+
+    // Instanciate all decoders, for the current, the preloaded and the fading song
+    const DecoderFactory decoderFactory(dataPath);
+    for (auto& decoderList : mDecoderLists) {
+        decoderList = decoderFactory.createList();
+    }
+    mRegistry.setup(mDecoderLists[0]);
+    mActiveDecoderList = 0;
+    mNextDecoderList = -1;
+    mFadingDecoderList = -1;
     mCurrentDecoder = nullptr;
 
+    // Measures pause while the read ahead is below half its target so the live audio keep the CPU
+    mLoudnessAnalyzer.setup(dataPath, loudnessCachePath, settings, mLifecycleMutex,
+        [this]() {
+            return isBusy();
+        },
+        [this](const uint64_t hash, const LoudnessAnalyzer::Result& result) {
+            if (mNormalizeLoudness && hash == mCurrentHash) {
+                mTrackGainDb = LoudnessAnalyzer::getTrackGain(result);
+                mPipeline.setTrackGain(mTrackGainDb);
+            }
+        });
+
     mState = FINISHED;
     return true;
 }
 
 void SoundEngine::cleanup() {
+    mLoudnessAnalyzer.cleanup();
     stop();
+
+    if (mDecoderThread != nullptr) {
+        mDecoderThreadRunning = false;
+        SDL_CondSignal(mDecoderCond);
+        SDL_WaitThread(mDecoderThread, nullptr);
+        mDecoderThread = nullptr;
+    }
+
     SDL_CloseAudioDevice(mAudioDevice);
-    mDecoderList.clear();
-}
 
-bool SoundEngine::canHandle(const std::shared_ptr<File> file) const {
-    return getDecoder(file) != nullptr;
+    // Decoders are kept ready between songs, release their libraries only now
+    SDL_LockMutex(mDecoderMutex);
+    SDL_LockMutex(mLifecycleMutex);
+    mRegistry.cleanup();
+    for (auto& decoderList : mDecoderLists) {
+        for (const auto& decoder : decoderList) {
+            decoder->cleanup();
+        }
+        decoderList.clear();
+    }
+    SDL_UnlockMutex(mLifecycleMutex);
+    SDL_UnlockMutex(mDecoderMutex);
 }
 
-bool SoundEngine::load(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings) {
+bool SoundEngine::load(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings, const int trackNumber) {
     const auto path = file->getPath();
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Loading %s ...\n", path.c_str());
+    startCommand();
+
+    mSkipSubTunes = settings->getBool(KEY_APP_SKIP_SUBTUNES, APP_SKIP_SUBTUNES_DEFAULT);
+    mNormalizeLoudness = settings->getBool(KEY_APP_LOUDNESS_NORMALIZATION, APP_LOUDNESS_NORMALIZATION_DEFAULT);
+
+    // Fade from the playing song instead of stopping it
+    if (mCrossfadeMs > 0 && mState == STARTED && loadCrossfade(file, settings, trackNumber)) {
+        return true;
+    }
 
     //Stop any previous songs
     stop();
 
-    // Try to find if any decoder can handle the file
-    mCurrentDecoder = getDecoder(file);
-
-    // Decoder not found ? :/
-    if (mCurrentDecoder == nullptr) {
-        mState = ERROR;
-        mError = std::string(STR_ERROR_NO_DECODER_CAN_HANDLE " \"").append(path).append("\"");
-        return false;
+    const auto readAhead = settings->getInt(KEY_APP_READ_AHEAD, APP_READ_AHEAD_DEFAULT);
+    if (readAhead >= 0 && readAhead < READ_AHEAD_COUNT) {
+        setReadAhead(READ_AHEAD_MS[readAhead]);
     }
 
-    // Get file content from File instance
-    std::vector<char> buffer;
-    if (!file->getAsBuffer(buffer)) {
+    // Get file content from File instance, mapped when possible
+    const auto content = file->getContent();
+    if (content == nullptr) {
         mState = ERROR;
 
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Error opening file: %s\n", file->getError().c_str());
@@ -121,38 +285,202 @@ bool SoundEngine::load(const std::shared_ptr<File> file, std::shared_ptr<Setting
         return false;
     }
 
+    // Try to find if any decoder can handle the file, from its name and content
+    const auto decoder = getDecoder(file, content->getView(), mActiveDecoderList);
+
+    // Decoder not found ? :/
+    if (decoder == nullptr) {
+        mState = ERROR;
+        mError = std::string(STR_ERROR_NO_DECODER_CAN_HANDLE " \"").append(path).append("\"");
+        return false;
+    }
+
     // Try to start song in internal decoder
-    if (!mCurrentDecoder->setup()) {
+    SDL_LockMutex(mDecoderMutex);
+    mCurrentDecoder = decoder;
+    mCurrentPath = path;
+    publishPath();
+    mCurrentHash = content->getView().getHash();
+    mCurrentFile = file;
+    mCurrentSettings = settings;
+    SDL_LockMutex(mLifecycleMutex);
+    const auto isSetup = mCurrentDecoder->setup();
+    const auto isPlaying = isSetup && mCurrentDecoder->play(content->getView(), settings) && selectTrack(mCurrentDecoder, trackNumber);
+    SDL_UnlockMutex(mLifecycleMutex);
+
+    if (!isSetup) {
         mState = ERROR;
         mError = STR_ERROR_DECODER_ERROR;
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Error while initializing decoder: %s\n", mCurrentDecoder->getError().c_str());
+        SDL_UnlockMutex(mDecoderMutex);
         return false;
     }
 
-    if (! mCurrentDecoder->play(buffer, settings)) {
+    if (!isPlaying) {
+        // Sniffed again on the next try, the file may have been replaced
+        mRegistry.forget(path);
         mState = ERROR;
         mError = STR_ERROR_CANT_PLAY_SONG;
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Error trying to play song: %s\n", mCurrentDecoder->getError().c_str());
+        SDL_UnlockMutex(mDecoderMutex);
         return false;
     }
 
+    if (!mPipeline.setup(mCurrentDecoder->getAudioSampleFormat(), mCurrentDecoder->getAudioChannels(), mCurrentDecoder->getAudioFrequency(),
+        mAudioSampleFormat, mAudioChannels, mAudioFrequency)) {
+
+        mState = ERROR;
+        mError = STR_ERROR_CANT_PLAY_SONG;
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unsupported decoder output: format 0x%X, %d channels\n",
+            mCurrentDecoder->getAudioSampleFormat(), mCurrentDecoder->getAudioChannels());
+        SDL_UnlockMutex(mDecoderMutex);
+        return false;
+    }
+    mPipeline.reset();
+    applyTrackGain();
+    resetTrackPosition();
+    if (mCurrentDecoder->getAudioFrequency() != mAudioFrequency) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Resampling from %d to %d Hz\n", mCurrentDecoder->getAudioFrequency(), mAudioFrequency);
+    }
+
+    // Let the decoder thread fill the buffer before the device start
+    mDecoderEnded = false;
+    SDL_CondSignal(mDecoderCond);
+    SDL_UnlockMutex(mDecoderMutex);
+
+    LoudnessAnalyzer::Result result;
+    if (mNormalizeLoudness && !mLoudnessAnalyzer.getResult(mCurrentHash, result)) {
+        mLoudnessAnalyzer.analyze(file);
+    }
+
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Song loaded %s ...\n", path.c_str());
     mState = FINISHED;
     mError = "";
     return true;
 }
 
+bool SoundEngine::loadCrossfade(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings, const int trackNumber) {
+    // On any issue the caller falls back to a regular load, which reports the error
+    cancelPreload();
+
+    SDL_LockMutex(mDecoderMutex);
+    const auto isPlaying = mCurrentDecoder != nullptr && !mDecoderEnded;
+    if (isPlaying) {
+        releaseFading();
+    }
+    const auto decoderList = getFreeDecoderList();
+    SDL_UnlockMutex(mDecoderMutex);
+
+    const auto content = isPlaying && decoderList >= 0 ? file->getContent() : nullptr;
+    if (content == nullptr) {
+        return false;
+    }
+
+    const auto decoder = openDecoder(file, content->getView(), settings, decoderList, trackNumber);
+    if (decoder == nullptr) {
+        return false;
+    }
+
+    const auto hash = content->getView().getHash();
+    SDL_LockMutex(mDecoderMutex);
+    const auto isStarted = beginCrossfade(decoder, decoderList, file->getPath(), hash, file);
+    if (isStarted) {
+        mCurrentSettings = settings;
+    } else {
+        decoder->stop();
+    }
+    SDL_UnlockMutex(mDecoderMutex);
+
+    if (!isStarted) {
+        return false;
+    }
+
+    LoudnessAnalyzer::Result result;
+    if (mNormalizeLoudness && !mLoudnessAnalyzer.getResult(hash, result)) {
+        mLoudnessAnalyzer.analyze(file);
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Song loaded with crossfade %s ...\n", file->getPath().c_str());
+    mError = "";
+    return true;
+}
+
+bool SoundEngine::preload(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings, const int trackNumber) {
+    // Drop any previously preloaded song, only one can be waiting
+    cancelPreload();
+
+    // The preload thread checks the content, a wrongly named file can still be preloaded
+    if (mCurrentDecoder == nullptr) {
+        return false;
+    }
+
+    // Reserve a decoder set not used by the current or the fading song
+    SDL_LockMutex(mDecoderMutex);
+    mNextDecoderList = getFreeDecoderList();
+    const auto decoderList = mNextDecoderList;
+    SDL_UnlockMutex(mDecoderMutex);
+
+    if (decoderList < 0) {
+        return false;
+    }
+
+    mPreloadFile = file;
+    mPreloadSettings = settings;
+    mPreloadTrackNumber = trackNumber;
+    if (mPreloadThread = SDL_CreateThread(SoundEngine::preloadThreadFunc, "OSP-Preload-Thread", this);
+        mPreloadThread == nullptr) {
+
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unable to start preload thread: %s\n", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void SoundEngine::cancelPreload() {
+    if (mPreloadThread != nullptr) {
+        SDL_WaitThread(mPreloadThread, nullptr);
+        mPreloadThread = nullptr;
+    }
+
+    SDL_LockMutex(mDecoderMutex);
+    if (mNextDecoder != nullptr) {
+        mNextDecoder->stop();
+        mNextDecoder = nullptr;
+        mNextPath.clear();
+        mNextFile = nullptr;
+    }
+    mNextDecoderList = -1;
+    SDL_UnlockMutex(mDecoderMutex);
+
+    mPreloadFile = nullptr;
+    mPreloadSettings = nullptr;
+}
+
 void SoundEngine::stop() {
+    cancelPreload();
+
     SDL_PauseAudioDevice(mAudioDevice, true);
     SDL_ClearQueuedAudio(mAudioDevice);
 
     SDL_LockAudioDevice(mAudioDevice);
+    SDL_LockMutex(mDecoderMutex);
     if (mCurrentDecoder != nullptr) {
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Stop current decoder.\n");
         mCurrentDecoder->stop();
-        mCurrentDecoder->cleanup();
         mCurrentDecoder = nullptr;
     }
+    releaseFading();
+    clearCommands();
+    mCurrentPath.clear();
+    publishPath();
+    mCurrentFile = nullptr;
+    mCurrentSettings = nullptr;
+    std::atomic_store(&mMetaData, mEmptyMetaData);
+    mPosition = -1;
+    mDecoderEnded = true;
+    mRingBuffer.clear();
+    SDL_UnlockMutex(mDecoderMutex);
     SDL_UnlockAudioDevice(mAudioDevice);
 
     mState = FINISHED;
@@ -176,105 +504,729 @@ void SoundEngine::play() {
 }
 
 bool SoundEngine::nextTrack() {
+    return changeTrack(1);
+}
+
+bool SoundEngine::prevTrack() {
+    return changeTrack(-1);
+}
+
+bool SoundEngine::changeTrack(const int offset) {
+    startCommand();
+    if (changeTrackCrossfade(offset)) {
+        return true;
+    }
+
     switch (mState) {
         case SoundEngine::State::STARTED:
         case SoundEngine::State::PAUSED:
         case SoundEngine::State::FINISHED_NATURAL:
-            if (mCurrentDecoder != nullptr) {
-                SDL_ClearQueuedAudio(mAudioDevice);
-                SDL_LockAudioDevice(mAudioDevice);
-                auto retCode = mCurrentDecoder->nextTrack();
-                SDL_UnlockAudioDevice(mAudioDevice);
-                return retCode;
-            }
             break;
         default:
-            break;
+            return false;
+    }
+
+    // Checked against the published sub tunes, a change not run yet counts as done
+    const auto metaData = std::atomic_load(&mMetaData);
+    const auto pendingTrack = mPendingTrack.load();
+    const auto trackNumber = (pendingTrack > 0 ? pendingTrack : metaData->trackInformation.trackNumber) + offset;
+    if (!metaData->hasDiskInformation || trackNumber < 1 || trackNumber > metaData->diskInformation.trackCount) {
+        return false;
     }
 
-    return false;
+    // Run by the decoder thread, the callback plays what is rendered ahead meanwhile
+    mPendingSeek = -1;
+    mPendingTrack = trackNumber;
+    SDL_CondSignal(mDecoderCond);
+    return true;
 }
 
-bool SoundEngine::prevTrack() {
-    switch (mState) {
-        case SoundEngine::State::STARTED:
-        case SoundEngine::State::PAUSED:
-        case SoundEngine::State::FINISHED_NATURAL:
-            if (mCurrentDecoder != nullptr) {
-                SDL_ClearQueuedAudio(mAudioDevice);
-                SDL_LockAudioDevice(mAudioDevice);
-                auto retCode = mCurrentDecoder->prevTrack();
-                SDL_UnlockAudioDevice(mAudioDevice);
-                return retCode;
-            }
-            break;
-        default:
-            break;
+void SoundEngine::setVolume(const int volume) {
+    // Squared for a more natural progression of the percentage
+    const auto linear = std::clamp(volume, 0, 100) / 100.0f;
+    mPipeline.setVolume(linear * linear);
+}
+
+void SoundEngine::setTrackGain(const float gainDb) {
+    mPipeline.setTrackGain(gainDb);
+}
+
+void SoundEngine::setLoudnessNormalization(const bool enabled) {
+    mNormalizeLoudness = enabled;
+    applyTrackGain();
+}
+
+void SoundEngine::setCrossfade(const int crossfade) {
+    if (crossfade >= 0 && crossfade < CROSSFADE_COUNT) {
+        mCrossfadeMs = CROSSFADE_MS[crossfade];
+    }
+}
+
+void SoundEngine::analyzeLoudness(const std::vector<std::shared_ptr<File>>& files) {
+    if (mNormalizeLoudness) {
+        mLoudnessAnalyzer.analyzeBackground(files);
+    }
+}
+
+bool SoundEngine::seek(const int position) {
+    startCommand();
+    // A song just loaded can be moved before it starts
+    const auto state = mState.load();
+    if ((state != STARTED && state != PAUSED && state != FINISHED) || position < 0 || std::atomic_load(&mMetaData) == mEmptyMetaData) {
+        return false;
+    }
+
+    // Run by the decoder thread, only the last position asked while it was busy is used
+    mPendingSeek = position;
+    SDL_CondSignal(mDecoderCond);
+    return true;
+}
+
+std::shared_ptr<Decoder> SoundEngine::getDecoder(const std::shared_ptr<File> file, const FileView content,
+    const int decoderList) {
+
+    // All lists hold the same decoders in the same order
+    const auto decoder = mRegistry.find(file->getPath(), content);
+    return decoder >= 0 ? mDecoderLists[decoderList][decoder] : nullptr;
+}
+
+int SoundEngine::getFreeDecoderList() const {
+    // Decoder mutex must be locked by the caller
+    for (auto decoderList=0; decoderList<DECODER_LIST_COUNT; decoderList++) {
+        if (decoderList != mActiveDecoderList && decoderList != mNextDecoderList && decoderList != mFadingDecoderList &&
+            decoderList != mCommandDecoderList) {
+
+            return decoderList;
+        }
     }
 
-    return false;
+    return -1;
 }
 
-std::shared_ptr<Decoder> SoundEngine::getDecoder(const std::shared_ptr<File> file) const {
-    // Try to find if any decoder can handle the file
-    auto extention = std::string(file->getPath().extension());
-    std::transform(extention.begin(), extention.end(), extention.begin(), ::tolower);
+std::shared_ptr<Decoder> SoundEngine::openDecoder(const std::shared_ptr<File> file, const FileView content,
+    std::shared_ptr<Settings> settings, const int decoderList, const int trackNumber) {
+
+    const auto decoder = getDecoder(file, content, decoderList);
+    if (decoder == nullptr) {
+        return nullptr;
+    }
+
+    // Without the decoder mutex, the playing song keeps rendering meanwhile
+    SDL_LockMutex(mLifecycleMutex);
+    const auto success = decoder->setup() && decoder->play(content, settings) && selectTrack(decoder, trackNumber);
+    if (!success) {
+        decoder->stop();
+    }
+    SDL_UnlockMutex(mLifecycleMutex);
 
-    std::shared_ptr<Decoder> decoderFound;
-    for (const auto decoder : mDecoderList) {
-        if (decoder->canRead(extention)) {
-            decoderFound = decoder;
+    if (!success) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Cannot open %s: %s\n", file->getPath().c_str(), decoder->getError().c_str());
+        mRegistry.forget(file->getPath());
+        return nullptr;
+    }
+
+    return decoder;
+}
+
+bool SoundEngine::selectTrack(const std::shared_ptr<Decoder> decoder, const int trackNumber) {
+    // Walk to the requested sub tune, if any
+    auto success = true;
+    for (auto tries=0; success && trackNumber > 0 && tries < 256; tries++) {
+        const auto current = decoder->getMetaData().trackInformation.trackNumber;
+        if (current == trackNumber) {
             break;
         }
+        success = current < trackNumber ? decoder->nextTrack() : decoder->prevTrack();
     }
 
-    return decoderFound;
+    return success;
 }
 
-void SoundEngine::audioCallback(void *userdata, Uint8* stream, int len) {
-    const auto soundEngine = static_cast<SoundEngine*>(userdata);
+bool SoundEngine::changeTrackCrossfade(const int offset) {
+    // Open the sub tune in another decoder set to fade from the playing one
+    SDL_LockMutex(mDecoderMutex);
+    if (mCrossfadeMs == 0 || mState != STARTED || mCurrentDecoder == nullptr || mCurrentFile == nullptr || mDecoderEnded) {
+        SDL_UnlockMutex(mDecoderMutex);
+        return false;
+    }
 
-    memset(stream, 0, len);
-    
-    if (soundEngine->mState != STARTED) {
-        // In case we come here.
+    const auto metaData = mCurrentDecoder->getMetaData();
+    const auto trackNumber = metaData.trackInformation.trackNumber + offset;
+    if (!metaData.hasDiskInformation || trackNumber < 1 || trackNumber > metaData.diskInformation.trackCount) {
+        SDL_UnlockMutex(mDecoderMutex);
+        return false;
+    }
+
+    // All sets may be in use, the fading one would be released by the new fade anyway
+    releaseFading();
+    const auto decoderList = getFreeDecoderList();
+    const auto file = mCurrentFile;
+    const auto settings = mCurrentSettings;
+    const auto path = mCurrentPath;
+    const uint64_t hash = mCurrentHash;
+    SDL_UnlockMutex(mDecoderMutex);
+
+    const auto content = decoderList >= 0 ? file->getContent() : nullptr;
+    if (content == nullptr) {
+        return false;
+    }
+
+    const auto decoder = openDecoder(file, content->getView(), settings, decoderList, trackNumber);
+    if (decoder == nullptr) {
+        return false;
+    }
+
+    SDL_LockMutex(mDecoderMutex);
+    const auto isStarted = beginCrossfade(decoder, decoderList, path, hash, file);
+    if (!isStarted) {
+        decoder->stop();
+    }
+    SDL_UnlockMutex(mDecoderMutex);
+
+    return isStarted;
+}
+
+bool SoundEngine::beginCrossfade(const std::shared_ptr<Decoder> decoder, const int decoderList, const std::filesystem::path path,
+    const uint64_t hash, const std::shared_ptr<File> file) {
+
+    // Decoder mutex must be locked by the caller
+    // Songs are mixed before the pipeline, they must share its input parameters
+    if (mCurrentDecoder == nullptr
+        || decoder->getAudioSampleFormat() != mCurrentDecoder->getAudioSampleFormat()
+        || decoder->getAudioChannels() != mCurrentDecoder->getAudioChannels()
+        || decoder->getAudioFrequency() != mCurrentDecoder->getAudioFrequency()) {
+
+        return false;
+    }
+
+    releaseFading();
+    mFadingDecoder = mCurrentDecoder;
+    mFadingDecoderList = mActiveDecoderList;
+    mFadingGainDb = mTrackGainDb;
+
+    mCurrentDecoder = decoder;
+    mActiveDecoderList = decoderList;
+    clearCommands();
+    mCurrentPath = path;
+    publishPath();
+    mCurrentHash = hash;
+    mCurrentFile = file;
+    applyTrackGain();
+    resetTrackPosition();
+
+    mFadeFrames = std::max((size_t) 1, (size_t) decoder->getAudioFrequency() * mCrossfadeMs / 1000);
+    mFadePosition = 0;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Crossfade to %s\n", mCurrentPath.c_str());
+    mDecoderEnded = false;
+    SDL_CondSignal(mDecoderCond);
+    return true;
+}
+
+bool SoundEngine::shouldCrossfadeToNext() const {
+    // Decoder mutex must be locked by the caller
+    // The end can only be anticipated when the duration is known
+    if (mCrossfadeMs == 0 || mNextDecoder == nullptr || mFadingDecoder != nullptr || mCurrentDuration <= 0) {
+        return false;
+    }
+
+    const auto frequency = (size_t) mCurrentDecoder->getAudioFrequency();
+    if (mTrackFrames + frequency * mCrossfadeMs / 1000 < (size_t) mCurrentDuration * frequency) {
+        return false;
+    }
+
+    // Only the last sub tune played leads to the next song
+    const auto metaData = mCurrentDecoder->getMetaData();
+    return mSkipSubTunes || !metaData.hasDiskInformation
+        || metaData.trackInformation.trackNumber >= metaData.diskInformation.trackCount;
+}
+
+void SoundEngine::crossfadeToNext() {
+    // Decoder mutex must be locked by the caller
+    if (!beginCrossfade(mNextDecoder, mNextDecoderList, mNextPath, mNextHash, mNextFile)) {
+        // Can't be mixed, it will start gapless at the end instead
+        mCurrentDuration = 0;
         return;
     }
 
-    if (soundEngine->mCurrentDecoder == nullptr) {
-        // In case we come here.
-        SDL_LockMutex(soundEngine->mStateMutex);
-        soundEngine->mState = FINISHED_NATURAL;
-        soundEngine->mError = "";
-        SDL_UnlockMutex(soundEngine->mStateMutex);
+    mNextDecoder = nullptr;
+    mNextDecoderList = -1;
+    mNextPath.clear();
+    mNextFile = nullptr;
+}
+
+void SoundEngine::releaseFading() {
+    // Decoder mutex must be locked by the caller
+    if (mFadingDecoder != nullptr) {
+        mFadingDecoder->stop();
+        mFadingDecoder = nullptr;
+    }
+    mFadingDecoderList = -1;
+}
+
+void SoundEngine::resetTrackPosition() {
+    // Decoder mutex must be locked by the caller
+    mTrackFrames = 0;
+    publishMetaData();
+}
+
+void SoundEngine::publishMetaData() {
+    // Decoder mutex must be locked by the caller
+    const auto metaData = std::make_shared<const Decoder::MetaData>(mCurrentDecoder->getMetaData());
+    mCurrentDuration = metaData->trackInformation.duration;
+    mPublishedTrackNumber = metaData->trackInformation.trackNumber;
+    std::atomic_store(&mMetaData, metaData);
+    publishPosition();
+}
+
+void SoundEngine::publishPath() {
+    // Decoder mutex must be locked by the caller
+    std::atomic_store(&mPublishedPath, std::make_shared<const std::filesystem::path>(mCurrentPath));
+}
+
+void SoundEngine::publishPosition() {
+    // Decoder mutex must be locked by the caller
+    // What is still in the ring buffer has not been heard yet
+    const auto decoderFrequency = mCurrentDecoder->getAudioFrequency();
+    const auto outputFrameSize = mPipeline.getOutputFrameSize();
+    const auto bufferedFrames = outputFrameSize > 0 ? mRingBuffer.getAvailableRead() / outputFrameSize : 0;
+    const auto position = decoderFrequency > 0 && mAudioFrequency > 0
+        ? (double) mTrackFrames / decoderFrequency - (double) bufferedFrames / mAudioFrequency
+        : 0.0;
+
+    mPosition = std::max(0, (int) position);
+}
+
+void SoundEngine::setReadAhead(const int readAheadMs) {
+    // Keep at least two device buffers so the decoder can work while the device consume
+    const auto frameSize = mAudioChannels * (SDL_AUDIO_BITSIZE(mAudioSampleFormat) / 8);
+    const auto capacity = std::max((size_t) (mAudioFrequency * readAheadMs / 1000) * frameSize,
+        (size_t) mAudioBufferSize * 2);
+
+    if (capacity == mRingBuffer.getCapacity()) {
         return;
     }
-    
-    switch (const auto retCode = soundEngine->mCurrentDecoder->process(stream, len);
-            retCode) {
 
-        case 0:
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Read ahead set to %d ms (%zu bytes).\n", readAheadMs, capacity);
+    SDL_LockAudioDevice(mAudioDevice);
+    SDL_LockMutex(mDecoderMutex);
+    mRingBuffer.resize(capacity);
+
+    // In low latency mode the setting is only the upper bound, start from the minimum
+    mReadAheadTarget = mLowLatency ? std::min(capacity, (size_t) mAudioBufferSize * 2) : capacity;
+    mLastUnderruns = mMetrics.getUnderruns();
+    mLastAdaptTicks = SDL_GetTicks();
+    mMetrics.setReadAhead(mReadAheadTarget * 1000.0f / (mAudioFrequency * frameSize));
+    SDL_UnlockMutex(mDecoderMutex);
+    SDL_UnlockAudioDevice(mAudioDevice);
+}
+
+void SoundEngine::adaptReadAhead() {
+    // Decoder mutex must be locked by the caller
+    if (!mLowLatency || mState != STARTED) {
+        return;
+    }
+
+    const auto frameSize = mAudioChannels * (SDL_AUDIO_BITSIZE(mAudioSampleFormat) / 8);
+    const auto capacity = mRingBuffer.getCapacity();
+    const auto underruns = mMetrics.getUnderruns();
+    const auto ticks = SDL_GetTicks();
+    size_t target = mReadAheadTarget;
+
+    if (underruns != mLastUnderruns) {
+        // Starving, double at once
+        target = std::min(capacity, target * 2);
+        mLastUnderruns = underruns;
+        mLastAdaptTicks = ticks;
+    } else if (ticks - mLastAdaptTicks > READ_AHEAD_SHRINK_DELAY_MS) {
+        // Stable for a while, give back a quarter but keep twice the slowest decoding seen
+        const auto decodeMargin = (size_t) (2.0f * mMetrics.getMaxProcessTime() * mAudioFrequency / 1000000.0f) * frameSize;
+        const auto minimum = std::min(capacity, std::max((size_t) mAudioBufferSize * 2, decodeMargin));
+        target = std::max(minimum, target * 3 / 4 / frameSize * frameSize);
+        mLastAdaptTicks = ticks;
+    }
+
+    if (target != mReadAheadTarget) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Read ahead target %zu -> %zu bytes.\n", mReadAheadTarget.load(), target);
+        mReadAheadTarget = target;
+        mMetrics.setReadAhead(target * 1000.0f / (mAudioFrequency * frameSize));
+    }
+}
+
+bool SoundEngine::isReadAheadFilled() const {
+    return mRingBuffer.getAvailableRead() >= mReadAheadTarget
+        || mRingBuffer.getAvailableWrite() < getMaxWriteSize(getDecoderChunkSize());
+}
+
+void SoundEngine::startCommand() {
+    // Latency is measured up to the first non silent sample the device gets
+    mCommandTime = AudioMetrics::now();
+}
+
+void SoundEngine::runCommands() {
+    // Decoder mutex must be locked by the caller
+    const auto pendingTrack = mPendingTrack.exchange(0);
+    const auto position = mPendingSeek.exchange(-1);
+    if ((pendingTrack <= 0 && position < 0) || mCurrentDecoder == nullptr || mCurrentFile == nullptr) {
+        return;
+    }
+
+    // Seeking may emulate minutes of the song. It is done in a free decoder set with the
+    // mutex released, like a preload, so stop, load and preload are not held meanwhile.
+    // The fading set, if any, is released to make room.
+    releaseFading();
+    const auto decoderList = getFreeDecoderList();
+    if (decoderList < 0) {
+        return;
+    }
+
+    const auto current = mCurrentDecoder;
+    const auto file = mCurrentFile;
+    const auto settings = mCurrentSettings;
+    const auto trackNumber = pendingTrack > 0 ? pendingTrack : current->getTrackNumber();
+    mCommandDecoderList = decoderList;
+    SDL_UnlockMutex(mDecoderMutex);
+
+    const auto content = file->getContent();
+    const auto decoder = content != nullptr ? openDecoder(file, content->getView(), settings, decoderList, trackNumber) : nullptr;
+    const auto isMoved = decoder != nullptr && (position < 0 || decoder->seek(position));
+
+    SDL_LockMutex(mDecoderMutex);
+    mCommandDecoderList = -1;
+
+    // Dropped if the song was stopped or replaced meanwhile
+    if (!isMoved || mCurrentDecoder != current) {
+        if (!isMoved) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Cannot move to track %d at %d s\n", trackNumber, position);
+        }
+        if (decoder != nullptr) {
+            decoder->stop();
+        }
+        return;
+    }
+
+    // Drop what was rendered ahead from the previous track or position
+    flush();
+    mCurrentDecoder->stop();
+    mCurrentDecoder = decoder;
+    mActiveDecoderList = decoderList;
+    resetTrackPosition();
+    if (position >= 0) {
+        mTrackFrames = (size_t) position * decoder->getAudioFrequency();
+        publishPosition();
+    }
+}
+
+void SoundEngine::clearCommands() {
+    // Decoder mutex must be locked by the caller, commands were meant for the previous song
+    mPendingTrack = 0;
+    mPendingSeek = -1;
+}
+
+void SoundEngine::flush() {
+    // Decoder mutex must be locked by the caller. The callback skips what was
+    // rendered so far on its next read, the new audio follows without locking it.
+    mRingBuffer.discard();
+    mPipeline.reset();
+    releaseFading();
+    mDecoderEnded = false;
+    SDL_CondSignal(mDecoderCond);
+}
+
+void SoundEngine::switchToNextDecoder() {
+    // Decoder mutex must be locked by the caller
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Gapless switch to %s\n", mNextPath.c_str());
+
+    releaseFading();
+    mCurrentDecoder->stop();
+
+    mCurrentDecoder = mNextDecoder;
+    clearCommands();
+    mCurrentPath = mNextPath;
+    publishPath();
+    mCurrentHash = mNextHash;
+    mCurrentFile = mNextFile;
+    mActiveDecoderList = mNextDecoderList;
+
+    mNextDecoder = nullptr;
+    mNextDecoderList = -1;
+    mNextPath.clear();
+    mNextFile = nullptr;
+
+    // Filters are only restarted if the new song use another frequency
+    if (!mPipeline.setup(mCurrentDecoder->getAudioSampleFormat(), mCurrentDecoder->getAudioChannels(), mCurrentDecoder->getAudioFrequency(),
+        mAudioSampleFormat, mAudioChannels, mAudioFrequency)) {
+
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unsupported decoder output for %s\n", mCurrentPath.c_str());
+        mDecoderEnded = true;
+    }
+    applyTrackGain();
+    resetTrackPosition();
+}
+
+void SoundEngine::applyTrackGain() {
+    LoudnessAnalyzer::Result result;
+    const auto gain = mNormalizeLoudness && mLoudnessAnalyzer.getResult(mCurrentHash, result)
+        ? LoudnessAnalyzer::getTrackGain(result)
+        : 0.0f;
+
+    mTrackGainDb = gain;
+    mPipeline.setTrackGain(gain);
+}
+
+size_t SoundEngine::getDecoderChunkSize() const {
+    // What the decoder must render to fill about one device buffer
+    const auto outputFrames = mAudioBufferSize / mPipeline.getOutputFrameSize();
+    return mPipeline.getInputFrames(outputFrames) * mPipeline.getInputFrameSize();
+}
+
+size_t SoundEngine::getMaxWriteSize(const size_t len) const {
+    // Room for the chunk and for the drain if the song ends with it
+    const auto inputFrames = len / mPipeline.getInputFrameSize() + mPipeline.getDrainFrames();
+    return mPipeline.getMaxOutputFrames(inputFrames) * mPipeline.getOutputFrameSize();
+}
+
+void SoundEngine::writeDecoded(const size_t len) {
+    // Decoder mutex must be locked by the caller
+    const auto maxSize = mPipeline.getMaxOutputFrames(len / mPipeline.getInputFrameSize()) * mPipeline.getOutputFrameSize();
+    if (mPipelineBuffer.size() < maxSize) {
+        mPipelineBuffer.resize(maxSize);
+    }
+
+    mTrackFrames += len / mPipeline.getInputFrameSize();
+    if (mFadingDecoder != nullptr) {
+        writeCrossfade(len);
+        return;
+    }
+
+    const auto written = mPipeline.process(mDecoderBuffer.data(), len, mPipelineBuffer.data());
+    if (mRingBuffer.write(mPipelineBuffer.data(), written) < written) {
+        mMetrics.addDroppedBuffer();
+    }
+}
+
+void SoundEngine::writeCrossfade(const size_t len) {
+    // Decoder mutex must be locked by the caller, mPipelineBuffer sized by writeDecoded
+    const auto format = mCurrentDecoder->getAudioSampleFormat();
+    const auto frames = len / mPipeline.getInputFrameSize();
+    const auto samples = frames * mCurrentDecoder->getAudioChannels();
+    if (mFadeBuffer.size() < len) {
+        mFadeBuffer.resize(len);
+    }
+
+    // The fading song renders as much, completed with silence once it ended
+    auto fadeLen = len;
+    const auto retCode = mFadingDecoder->process(mFadeBuffer.data(), len);
+    if (retCode == 1) {
+        fadeLen = std::min(len, (size_t) mFadingDecoder->getRenderedLength());
+    } else if (retCode != 0) {
+        fadeLen = 0;
+    }
+    memset(mFadeBuffer.data() + fadeLen, 0, len - fadeLen);
+
+    for (auto i=0; i<2; i++) {
+        mMixBuffers[i].resize(samples);
+        mFadeGains[i].resize(frames);
+    }
+    convertToFloat(mDecoderBuffer.data(), format, mMixBuffers[0].data(), samples);
+    convertToFloat(mFadeBuffer.data(), format, mMixBuffers[1].data(), samples);
+
+    // Equal power curves, the pipeline applies the new song gain so the fading
+    // one is corrected from its own
+    const auto fadingGain = std::pow(10.0f, (mFadingGainDb - mTrackGainDb) / 20.0f);
+    for (size_t frame=0; frame<frames; frame++) {
+        const auto position = std::min(1.0f, (float) (mFadePosition + frame) / mFadeFrames);
+        mFadeGains[0][frame] = std::sin(position * HALF_PI);
+        mFadeGains[1][frame] = std::cos(position * HALF_PI) * fadingGain;
+    }
+
+    const auto channels = mCurrentDecoder->getAudioChannels();
+    SampleKernels::applyFrameGains(mMixBuffers[0].data(), mFadeGains[0].data(), frames, channels);
+    SampleKernels::applyFrameGains(mMixBuffers[1].data(), mFadeGains[1].data(), frames, channels);
+    SampleKernels::mix(mMixBuffers[0].data(), mMixBuffers[1].data(), samples);
+
+    const auto written = mPipeline.processFloat(mMixBuffers[0].data(), frames, mPipelineBuffer.data());
+    if (mRingBuffer.write(mPipelineBuffer.data(), written) < written) {
+        mMetrics.addDroppedBuffer();
+    }
+
+    mFadePosition += frames;
+    if (retCode != 0 || mFadePosition >= mFadeFrames) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Crossfade done.\n");
+        releaseFading();
+    }
+}
+
+void SoundEngine::writeDrain() {
+    // Decoder mutex must be locked by the caller
+    const auto maxSize = mPipeline.getMaxOutputFrames(mPipeline.getDrainFrames()) * mPipeline.getOutputFrameSize();
+    if (mPipelineBuffer.size() < maxSize) {
+        mPipelineBuffer.resize(maxSize);
+    }
+
+    const auto written = mPipeline.drain(mPipelineBuffer.data());
+    if (mRingBuffer.write(mPipelineBuffer.data(), written) < written) {
+        mMetrics.addDroppedBuffer();
+    }
+}
+
+int SoundEngine::preloadThreadFunc(void* userData) {
+    const auto soundEngine = static_cast<SoundEngine*>(userData);
+    const auto file = soundEngine->mPreloadFile;
+    const auto settings = soundEngine->mPreloadSettings;
+    const auto path = file->getPath();
+
+    const auto content = file->getContent();
+    if (content == nullptr) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Cannot preload %s: %s\n", path.c_str(), file->getError().c_str());
+        return 0;
+    }
+
+    // Use the decoder set reserved by preload()
+    const auto decoder = soundEngine->openDecoder(file, content->getView(), settings, soundEngine->mNextDecoderList,
+        soundEngine->mPreloadTrackNumber);
+    if (decoder == nullptr) {
+        return 0;
+    }
+
+    const auto hash = content->getView().getHash();
+    SDL_LockMutex(soundEngine->mDecoderMutex);
+    soundEngine->mNextDecoder = decoder;
+    soundEngine->mNextPath = path;
+    soundEngine->mNextHash = hash;
+    soundEngine->mNextFile = file;
+    SDL_UnlockMutex(soundEngine->mDecoderMutex);
+
+    // Have its gain ready before it starts
+    LoudnessAnalyzer::Result result;
+    if (soundEngine->mNormalizeLoudness && !soundEngine->mLoudnessAnalyzer.getResult(hash, result)) {
+        soundEngine->mLoudnessAnalyzer.analyze(file);
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Song preloaded %s ...\n", path.c_str());
+    return 0;
+}
+
+int SoundEngine::decoderThreadFunc(void* userData) {
+    const auto soundEngine = static_cast<SoundEngine*>(userData);
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+    SDL_LockMutex(soundEngine->mDecoderMutex);
+    while (soundEngine->mDecoderThreadRunning) {
+        const auto& decoder = soundEngine->mCurrentDecoder;
+        const auto chunkSize = soundEngine->getDecoderChunkSize();
+        if (soundEngine->mDecoderBuffer.size() < chunkSize) {
+            soundEngine->mDecoderBuffer.resize(chunkSize);
+        }
+
+        soundEngine->runCommands();
+        soundEngine->adaptReadAhead();
+        if (decoder == nullptr || soundEngine->mDecoderEnded || soundEngine->isReadAheadFilled()) {
+
+            // Nothing to do until the callback consume some data or a new song is loaded
+            SDL_CondWaitTimeout(soundEngine->mDecoderCond, soundEngine->mDecoderMutex, 10);
+            continue;
+        }
+
+        if (soundEngine->shouldCrossfadeToNext()) {
+            soundEngine->crossfadeToNext();
+        }
+
+        const auto processStart = AudioMetrics::now();
+        const auto retCode = decoder->process(soundEngine->mDecoderBuffer.data(), chunkSize);
+        soundEngine->mMetrics.addProcess(processStart, AudioMetrics::now(),
+            chunkSize / soundEngine->mPipeline.getInputFrameSize(), decoder->getAudioFrequency());
+
+        switch (retCode) {
+
+            case 0:
                 // OK
-            break;
+                soundEngine->writeDecoded(chunkSize);
+
+                // Some decoders move to the next sub tune by themselves
+                if (decoder->getTrackNumber() != soundEngine->mPublishedTrackNumber) {
+                    soundEngine->resetTrackPosition();
+                } else {
+                    soundEngine->publishPosition();
+                }
+                break;
+
+            case 1:
+                // NATURAL FINISH, keep only what was really rendered then continue
+                // with the next sub tune or the preloaded song if any.
+                // Otherwise the callback will notify it once the buffer is empty.
+                soundEngine->writeDecoded(decoder->getRenderedLength());
+                if (!soundEngine->mSkipSubTunes && decoder->nextTrack()) {
+                    soundEngine->resetTrackPosition();
+                    break;
+                }
+
+                if (soundEngine->mNextDecoder != nullptr) {
+                    soundEngine->switchToNextDecoder();
+                } else {
+                    // Get the end of the song still in the filters
+                    soundEngine->writeDrain();
+                    soundEngine->mDecoderEnded = true;
+                }
+                break;
+
+            case -1:
+                // DECODER ERROR
+                soundEngine->mDecoderEnded = true;
+                SDL_LockMutex(soundEngine->mStateMutex);
+                soundEngine->mState = ERROR;
+                soundEngine->mError = STR_ERROR_DECODER_ERROR;
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SoundEngine error: %s\n", decoder->getError().c_str());
+                SDL_UnlockMutex(soundEngine->mStateMutex);
+                break;
+
+            default:
+                break;
+        }
+    }
+    SDL_UnlockMutex(soundEngine->mDecoderMutex);
+
+    return 0;
+}
 
-        case 1: 
-            // NATURAL FINISH
+void SoundEngine::audioCallback(void *userdata, Uint8* stream, int len) {
+    const auto soundEngine = static_cast<SoundEngine*>(userdata);
+    const auto start = AudioMetrics::now();
+
+    if (soundEngine->mState != STARTED) {
+        // In case we come here.
+        memset(stream, 0, len);
+        return;
+    }
+
+    // Only copy what the decoder thread rendered ahead, fill with silence if late
+    const auto read = soundEngine->mRingBuffer.read(stream, len);
+    if (const Uint64 commandTime = soundEngine->mCommandTime;
+        commandTime != 0) {
+
+        // Silence is all zero bytes in every format we output
+        const auto end = AudioMetrics::now();
+        if (std::any_of(stream, stream + read, [](const Uint8 byte) { return byte != 0; })) {
+            soundEngine->mMetrics.addCommandLatency(commandTime, end);
+            soundEngine->mCommandTime = 0;
+        } else if ((end - commandTime) * 1000 / SDL_GetPerformanceFrequency() > COMMAND_LATENCY_TIMEOUT_MS) {
+            soundEngine->mCommandTime = 0;
+        }
+    }
+    if (read < (size_t) len) {
+        memset(stream + read, 0, len - read);
+        if (soundEngine->mDecoderEnded && soundEngine->mRingBuffer.getAvailableRead() == 0) {
             SDL_LockMutex(soundEngine->mStateMutex);
             soundEngine->mState = FINISHED_NATURAL;
             soundEngine->mError = "";
             SDL_UnlockMutex(soundEngine->mStateMutex);
-            break;
-        
-        case -1:
-            // DECODER ERROR
-            SDL_LockMutex(soundEngine->mStateMutex);
-            soundEngine->mState = ERROR;
-            soundEngine->mError = STR_ERROR_DECODER_ERROR;
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SoundEngine error: %s\n", soundEngine->mCurrentDecoder->getError().c_str());
-            SDL_UnlockMutex(soundEngine->mStateMutex);
-            break;
-
-        default:
-            break;
+        }
     }
+
+    SDL_CondSignal(soundEngine->mDecoderCond);
+
+    // Running short while the song is still decoding is an underrun
+    const auto& ringBuffer = soundEngine->mRingBuffer;
+    const auto bufferFill = ringBuffer.getCapacity() > 0 ? 100.0f * ringBuffer.getAvailableRead() / ringBuffer.getCapacity() : 0.0f;
+    soundEngine->mMetrics.addCallback(start, AudioMetrics::now(), bufferFill, read < (size_t) len && !soundEngine->mDecoderEnded);
 }
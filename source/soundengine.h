@@ -2,13 +2,20 @@
 
 #include "filesystem/file.h"
 #include "decoder/decoder.h"
+#include "decoder/decoderregistry.h"
 #include "settings.h"
+#include "audio/ringbuffer.h"
+#include "audio/audiopipeline.h"
+#include "audio/audiometrics.h"
+#include "loudnessanalyzer.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <filesystem>
 #include <memory>
 #include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
 
 class SoundEngine {
 
@@ -24,40 +31,181 @@ class SoundEngine {
         SoundEngine();
         virtual ~SoundEngine();
 
-        bool setup(const std::filesystem::path dataPath);
+        // The settings the songs are played with, the loudness measures use the same
+        bool setup(const std::filesystem::path dataPath, const std::filesystem::path loudnessCachePath,
+            std::shared_ptr<Settings> settings, const bool lowLatency);
         void cleanup();
 
-        bool canHandle(const std::shared_ptr<File> file) const;
-        bool load(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings);
+        // A track number of 0 starts at the sub tune chosen by the decoder
+        bool load(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings, const int trackNumber);
+        bool preload(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings, const int trackNumber);
         void stop();
         void pause();
         void play();
 
+        // Run by the decoder thread, true once posted. Track changes are checked against the
+        // published metadata, a seek may still be refused by the decoder.
         bool nextTrack();
         bool prevTrack();
+        bool seek(const int position);
 
-        Decoder::MetaData getMetaData() const;
+        void setVolume(const int volume);
+        void setTrackGain(const float gainDb);
+        void setLoudnessNormalization(const bool enabled);
+        void setCrossfade(const int crossfade);
+        void analyzeLoudness(const std::vector<std::shared_ptr<File>>& files);
+
+        // Immutable snapshot published on each song or sub tune change, without locking
+        std::shared_ptr<const Decoder::MetaData> getMetaData() const;
+        // Playback position in seconds, -1 when nothing is playing
+        int getPosition() const;
+        // Published with the song, without locking
+        std::filesystem::path getCurrentPath() const;
         State getState() const;
         std::string getError() const;
         void clearError();
+        AudioMetrics& getMetrics();
+        // Decoders setup, play, stop and cleanup write their libraries globals, some from
+        // the settings given to play. Every owner of decoders runs them under this mutex,
+        // the decoder thread never takes it.
+        SDL_mutex* getLifecycleMutex() const;
+        // Live audio is below half its read ahead target, background work should wait
+        bool isBusy() const;
 
     private:
-        const Decoder::MetaData mEmptyMetaData;
+        const std::shared_ptr<const Decoder::MetaData> mEmptyMetaData;
         SDL_mutex* mStateMutex;
         std::string mError;
-        State mState;
+        std::atomic<State> mState;
 
         SDL_AudioDeviceID mAudioDevice;
         SDL_AudioFormat mAudioSampleFormat;
         uint8_t mAudioChannels;
         int mAudioFrequency;
+        int mAudioBufferSize;
+
+        // The decoder thread renders ahead into mRingBuffer, the audio callback only copy from it.
+        // mDecoderMutex protect mCurrentDecoder against the decoder thread.
+        SDL_Thread* mDecoderThread;
+        SDL_mutex* mDecoderMutex;
+        // Taken after mDecoderMutex when both are
+        SDL_mutex* mLifecycleMutex;
+        SDL_cond* mDecoderCond;
+        std::atomic<bool> mDecoderThreadRunning;
+        std::atomic<bool> mDecoderEnded;
+        std::vector<Uint8> mDecoderBuffer;
+        RingBuffer mRingBuffer;
+
+        // Decoders render at their own frequency and format, converted here to the
+        // device ones with volume, track gain and limiting on the way.
+        AudioPipeline mPipeline;
+        std::vector<Uint8> mPipelineBuffer;
+        AudioMetrics mMetrics;
+
+        // Low latency mode: small device buffer and a read ahead target below the ring
+        // capacity, grown on underruns and given back slowly while the sound is stable.
+        bool mLowLatency;
+        std::atomic<size_t> mReadAheadTarget;
+        Uint64 mLastUnderruns;
+        Uint32 mLastAdaptTicks;
+
+        // Set by commands, cleared by the callback on the first non silent sample
+        std::atomic<Uint64> mCommandTime;
+
+        // Track number and position in seconds posted by the UI, 0 and -1 when none
+        std::atomic<int> mPendingTrack;
+        std::atomic<int> mPendingSeek;
 
-        std::vector<std::shared_ptr<Decoder>> mDecoderList;
+        // Track gain comes from the loudness measured in background, by content hash
+        LoudnessAnalyzer mLoudnessAnalyzer;
+        std::atomic<bool> mNormalizeLoudness;
+        std::atomic<uint64_t> mCurrentHash;
+        std::atomic<float> mTrackGainDb;
+        uint64_t mNextHash;
+
+        // Three sets of decoders are used in turn: one for the current song, one
+        // to preload the next song, so it can start on the exact sample where the
+        // current one ends, and one for the song fading out during a crossfade.
+        // A track change or seek is prepared in a free set, reserved meanwhile.
+        static const int DECODER_LIST_COUNT = 3;
+        std::vector<std::shared_ptr<Decoder>> mDecoderLists[DECODER_LIST_COUNT];
+        DecoderRegistry mRegistry;
+        int mActiveDecoderList;
+        int mNextDecoderList;
+        int mCommandDecoderList;
         std::shared_ptr<Decoder> mCurrentDecoder;
+        std::filesystem::path mCurrentPath;
+        std::shared_ptr<File> mCurrentFile;
+        std::shared_ptr<Settings> mCurrentSettings;
+        std::shared_ptr<Decoder> mNextDecoder;
+        std::filesystem::path mNextPath;
+        std::shared_ptr<File> mNextFile;
+        bool mSkipSubTunes;
+
+        // Crossfade, the previous decoder keep rendering in mFadeBuffer and is mixed
+        // in with an equal power curve. mTrackFrames counts what the current decoder
+        // rendered so its end can be anticipated when the duration is known.
+        std::atomic<int> mCrossfadeMs;
+        std::shared_ptr<Decoder> mFadingDecoder;
+        int mFadingDecoderList;
+        size_t mFadeFrames;
+        size_t mFadePosition;
+        float mFadingGainDb;
+        std::vector<Uint8> mFadeBuffer;
+        std::vector<float> mMixBuffers[2];
+        std::vector<float> mFadeGains[2];
+        size_t mTrackFrames;
+        int mCurrentDuration;
+
+        // Read by the UI at any time, written with the decoder mutex locked. Strings
+        // are only copied when the track changes, the position as the song plays.
+        std::shared_ptr<const Decoder::MetaData> mMetaData;
+        std::shared_ptr<const std::filesystem::path> mPublishedPath;
+        int mPublishedTrackNumber;
+        std::atomic<int> mPosition;
+
+        SDL_Thread* mPreloadThread;
+        std::shared_ptr<File> mPreloadFile;
+        std::shared_ptr<Settings> mPreloadSettings;
+        int mPreloadTrackNumber;
         
         SoundEngine(const SoundEngine& copy);
         
-        std::shared_ptr<Decoder> getDecoder(const std::shared_ptr<File> file) const;
+        std::shared_ptr<Decoder> getDecoder(const std::shared_ptr<File> file, const FileView content, const int decoderList);
+        int getFreeDecoderList() const;
+        std::shared_ptr<Decoder> openDecoder(const std::shared_ptr<File> file, const FileView content,
+            std::shared_ptr<Settings> settings, const int decoderList, const int trackNumber);
+        static bool selectTrack(const std::shared_ptr<Decoder> decoder, const int trackNumber);
+        bool loadCrossfade(const std::shared_ptr<File> file, std::shared_ptr<Settings> settings, const int trackNumber);
+        bool changeTrack(const int offset);
+        bool changeTrackCrossfade(const int offset);
+        bool beginCrossfade(const std::shared_ptr<Decoder> decoder, const int decoderList, const std::filesystem::path path,
+            const uint64_t hash, const std::shared_ptr<File> file);
+        bool shouldCrossfadeToNext() const;
+        void crossfadeToNext();
+        void releaseFading();
+        void resetTrackPosition();
+        void publishMetaData();
+        void publishPath();
+        void publishPosition();
+        void setReadAhead(const int readAheadMs);
+        void adaptReadAhead();
+        bool isReadAheadFilled() const;
+        void startCommand();
+        void runCommands();
+        void clearCommands();
+        void flush();
+        void cancelPreload();
+        void switchToNextDecoder();
+        size_t getDecoderChunkSize() const;
+        size_t getMaxWriteSize(const size_t len) const;
+        void writeDecoded(const size_t len);
+        void writeCrossfade(const size_t len);
+        void writeDrain();
+        void applyTrackGain();
+
+        static int decoderThreadFunc(void* userData);
+        static int preloadThreadFunc(void* userData);
         static void audioCallback(void *userdata, Uint8* stream, int len);
 
 };
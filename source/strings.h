@@ -2,7 +2,7 @@
 #include "IconsMaterialDesignIcons_c.h"
 
 #define STR_ABOUT_WINDOW_TITLE          ICON_MDI_INFORMATION " About"
-#define STR_METRICS_WINDOW_TITLE        ICON_MDI_CHART_BAR " Dear ImGui Metrics"
+#define STR_METRICS_WINDOW_TITLE        ICON_MDI_CHART_BAR " Metrics"
 #define STR_SETTINGS_WINDOW_TITLE       ICON_MDI_SETTINGS " Settings"
 #define STR_MENU_ITEM_SHOW_WORKSPACE    ICON_MDI_DESKTOP_MAC_DASHBOARD " Show Workspace"
 #define STR_MENU_ITEM_THEME             ICON_MDI_PALETTE " Theme"
@@ -10,17 +10,37 @@
 #define STR_MENU_ITEM_FONT              "Font"
 #define STR_MENU_ITEM_HELP              "Help"
 #define STR_MENU_ITEM_QUIT              ICON_MDI_LOGOUT " Quit"
+#define STR_MENU_ITEM_PLAYBACK          "Playback"
+#define STR_MENU_ITEM_SHUFFLE           ICON_MDI_SHUFFLE " Shuffle"
+#define STR_MENU_ITEM_REPEAT            ICON_MDI_REPEAT " Repeat"
+#define STR_MENU_ITEM_REPEAT_OFF        "Off"
+#define STR_MENU_ITEM_REPEAT_ALL        "All"
+#define STR_MENU_ITEM_REPEAT_ONE        "One"
+#define STR_MENU_ITEM_CLEAR_QUEUE       ICON_MDI_PLAYLIST_REMOVE " Clear queue"
+#define STR_MENU_ITEM_ADD_TO_QUEUE      ICON_MDI_PLAYLIST_PLUS " Add to queue"
 
 #define STR_SETTINGS_MOUSE_EMULATION        "Mouse emulation"
 #define STR_SETTINGS_TOUCH_ENABLED          "Touch support"
 #define STR_SKIP_UNSUPPORTED_FILES          "Auto skip unsupported files"
 #define STR_ALWAYS_START_FIRST_TUNE         "Always start at the first track of a disk"
 #define STR_SKIP_SUBTUNES                   "Skip sub tunes"
+#define STR_READ_AHEAD                      "Read ahead"
+#define STR_VOLUME                          "Volume"
+#define STR_LOUDNESS_NORMALIZATION          "Loudness normalization"
+#define STR_LOW_LATENCY                     "Low latency"
+#define STR_CROSSFADE                       "Crossfade"
+#define STR_LIBRARY_INDEXING                "Library indexing"
 #define STR_TOOLTIP_MOUSE_EMULATION         "Make the controller move the mouse.\nOtherwise if no mouse is connected the mouse cursor\nis hidden and normal gamepad control is used."
 #define STR_TOOLTIP_TOUCH_ENABLE            "Enable touch control for devices that handle it."
 #define STR_TOOLTIP_SKIP_UNSUPPORTED_FILES  "Skip a file if it can't be played."
 #define STR_TOOLTIP_ALWAYS_START_FIRST_TUNE "Ignore default tune of a disk and always start the first if applicable."
 #define STR_TOOLTIP_SKIP_SUBTUNES           "Don't play sub tunes."
+#define STR_TOOLTIP_VOLUME                  "Master volume, peaks are limited instead of clipping."
+#define STR_TOOLTIP_LOUDNESS_NORMALIZATION  "Play all songs at the same loudness.\nSongs are measured in background the first time they are played or browsed."
+#define STR_TOOLTIP_CROSSFADE               "Fade between songs and sub tunes changed from the player.\nAt the end of a song it needs its duration to be known."
+#define STR_TOOLTIP_LOW_LATENCY             "Use a small audio buffer and only read ahead what the decoder needs,\ngrowing it when the sound starves. Applied on restart."
+#define STR_TOOLTIP_LIBRARY_INDEXING        "Walk all the mount points in background to index the songs and their informations.\nOnly new or modified songs are read again. Applied on restart."
+#define STR_TOOLTIP_READ_AHEAD              "Amount of sound decoded in advance.\nIncrease it if the sound crackle with heavy emulation settings."
 #define STR_TOOLTIP_SC68_LOOP               "Define if the sound loop forever or not after the end."
 #define STR_TOOLTIP_SC68_ENABLE_ASIDIFIER   "Enable aSIDifier for track supporting it."
 #define STR_TOOLTIP_SC68_ASIDIFIER_FORCE    "Force aSIDifier even on incompatible tracks."
@@ -54,6 +74,7 @@
 #define STR_TOTAL_DURATION              "Total duration"
 #define STR_TRACK_INFORMATION           "Track Information"
 #define STR_AUTHOR                      "Author"
+#define STR_SEARCH_LIBRARY              "Search the library"
 #define STR_TRACK_NUMBER                "Track number"
 #define STR_PLAY_TIME                   "Play time"
 #define STR_DURATION                    "Duration"
@@ -77,6 +98,23 @@
 #define STR_IGNORE_SILENCE              "Ignore silence"
 #define STR_MAX_TO_MIX                  "Max to mix"
 #define STR_PLAYING_S                   ICON_MDI_MUSIC " Playing: %s"
+#define STR_SEEK_POSITION               "%d:%02d / %d:%02d"
+#define STR_AUDIO_CALLBACKS             "Callbacks: %llu, period %.0f us"
+#define STR_AUDIO_UNDERRUNS             "Underruns: %llu, dropped buffers: %llu"
+#define STR_DECODER_CHUNKS              "Decoded chunks: %llu, realtime factor x%.1f"
+#define STR_READ_AHEAD_TARGET           "Read ahead: %.0f ms"
+#define STR_COMMAND_LATENCY             "Command to sound: last %.1f ms, max %.1f ms (%llu)"
+#define STR_CALLBACK_TIME               "Callback time (us)"
+#define STR_CALLBACK_JITTER             "Callback jitter (us)"
+#define STR_BUFFER_FILL                 "Buffer fill (%)"
+#define STR_PROCESS_TIME                "Decoder process time (us)"
+#define STR_CALLBACK_HISTOGRAM          "Callback time histogram"
+#define STR_PROCESS_HISTOGRAM           "Process time histogram"
+#define STR_PLOT_LAST_MAX               "last %.0f, max %.0f"
+#define STR_HISTOGRAM_RANGE             "0 .. %d us and more"
+#define STR_RESET                       "Reset"
+#define STR_DUMP_TO_FILE                "Dump to file"
+#define STR_SHOW_IMGUI_METRICS          "Dear ImGui metrics"
 
 
 // Errors
@@ -89,4 +127,5 @@
 #define STR_ERROR_CANT_OPEN_FILE                "Can't open file"
 #define STR_ERROR_CANT_PLAY_SONG                "Can't play song"
 #define STR_ERROR_DECODER_ERROR                 "Decoder error."
+#define STR_ERROR_DECODER_THREAD_START          "Unable to start decoder thread."
 #define STR_ERROR_CANNOT_NAVIGATE               "Cannot navigate"
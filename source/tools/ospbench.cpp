@@ -0,0 +1,332 @@
+// Decoders throughput benchmark.
+// osp-bench [-t seconds] [-b frames] <corpus directory>
+// Render the first seconds of every file of the corpus with each relevant
+// settings combination of its decoder and report speed and process() timings.
+// osp-bench -l <corpus directory>
+// Measure the time from load and next track commands to the first non silent
+// sample reaching the device, through the whole engine, in both buffer modes.
+
+#include "../soundengine.h"
+#include "../decoder/decoderfactory.h"
+#include "../decoder/decoderregistry.h"
+#include "../settings.h"
+#include "../decoder/dumb/dumb_settings_strings.h"
+#include "../decoder/gme/gme_settings_strings.h"
+#include "../decoder/sidplayfp/sidplayfp_settings_strings.h"
+#include "../app_settings_strings.h"
+#include "../filesystem/local/localfilesystem.h"
+#include "../platform.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+
+struct Combination {
+    std::string name;
+    std::vector<std::pair<std::string, int>> intSettings;
+    std::vector<std::pair<std::string, bool>> boolSettings;
+};
+
+struct Measure {
+    int files = 0;
+    uint64_t frames = 0;
+    double seconds = 0;
+    double renderTime = 0;
+    std::vector<double> callTimes;
+};
+
+struct Latency {
+    int files = 0;
+    std::vector<double> loads;
+    std::vector<double> nextTracks;
+    Uint64 underruns = 0;
+    float readAhead = 0;
+};
+
+static const Uint32 LATENCY_TIMEOUT_MS = 5000;
+static const Uint32 LATENCY_PLAY_MS = 500;
+
+static void usage() {
+    fprintf(stderr, "usage: osp-bench [-t seconds] [-b frames] <corpus directory>\n"
+                    "       osp-bench -l <corpus directory>\n"
+                    "  -t  seconds rendered per file and settings (default: 30)\n"
+                    "  -b  frames per process call (default: 2048)\n"
+                    "  -l  measure command to sound latency instead, with a null audio output\n");
+}
+
+// Settings worth comparing on a slow CPU, for each decoder
+static std::vector<Combination> getCombinations(const std::string decoderName) {
+    std::vector<Combination> combinations;
+
+    if (decoderName == "sidplayfp") {
+        const char* emulations[] = { "ReSIDfp", "ReSID" };
+        const char* methods[] = { "interpolate", "resample" };
+        for (auto emulation=0; emulation<2; emulation++) {
+            for (auto method=0; method<2; method++) {
+                for (auto fast=0; fast<2; fast++) {
+                    combinations.push_back({
+                        .name = std::string(emulations[emulation]).append(" ").append(methods[method]).append(fast ? " fast" : ""),
+                        .intSettings = { { KEY_SIDPLAYFP_SID_EMULATION, emulation }, { KEY_SIDPLAYFP_SAMPLING_METHOD, method } },
+                        .boolSettings = { { KEY_SIDPLAYFP_FAST_SAMPLING, fast == 1 } }
+                    });
+                }
+            }
+        }
+    } else if (decoderName == "dumb") {
+        const char* maxToMix[] = { "64", "128", "256", "512" };
+        for (auto i=0; i<4; i++) {
+            combinations.push_back({
+                .name = std::string("max to mix ").append(maxToMix[i]),
+                .intSettings = { { KEY_DUMB_MAX_TO_MIX, i } },
+                .boolSettings = {}
+            });
+        }
+    } else if (decoderName == "gme") {
+        for (auto accuracy=0; accuracy<2; accuracy++) {
+            combinations.push_back({
+                .name = accuracy ? "accuracy on" : "accuracy off",
+                .intSettings = {},
+                .boolSettings = { { KEY_GME_ENABLE_ACCURACY, accuracy == 1 } }
+            });
+        }
+    } else {
+        combinations.push_back({ .name = "default", .intSettings = {}, .boolSettings = {} });
+    }
+
+    return combinations;
+}
+
+static double getPercentile(std::vector<double>& values, const double percentile) {
+    if (values.empty()) {
+        return 0;
+    }
+
+    const auto index = std::min(values.size() - 1, (size_t) (percentile * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static bool benchFile(const std::shared_ptr<Decoder> decoder, const FileView content,
+    const std::shared_ptr<Settings> settings, const int seconds, const int chunkFrames, Measure& measure) {
+
+    if (!decoder->setup() || !decoder->play(content, settings)) {
+        decoder->stop();
+        decoder->cleanup();
+        return false;
+    }
+
+    const auto frequency = decoder->getAudioFrequency();
+    const auto frameSize = decoder->getAudioChannels() * (SDL_AUDIO_BITSIZE(decoder->getAudioSampleFormat()) / 8);
+    const auto maxFrames = (uint64_t) seconds * frequency;
+    const auto counterFrequency = (double) SDL_GetPerformanceFrequency();
+    std::vector<Uint8> stream(chunkFrames * frameSize);
+
+    uint64_t frames = 0;
+    while (frames < maxFrames) {
+        const auto startTime = SDL_GetPerformanceCounter();
+        const auto retCode = decoder->process(stream.data(), stream.size());
+        const auto callTime = (SDL_GetPerformanceCounter() - startTime) / counterFrequency;
+
+        if (retCode < 0) {
+            break;
+        }
+
+        frames += (retCode == 1 ? decoder->getRenderedLength() : stream.size()) / frameSize;
+        measure.callTimes.push_back(callTime);
+        measure.renderTime += callTime;
+
+        if (retCode == 1) {
+            break;
+        }
+    }
+
+    decoder->stop();
+    decoder->cleanup();
+
+    measure.files++;
+    measure.frames += frames;
+    measure.seconds += (double) frames / frequency;
+    return true;
+}
+
+static bool waitCommand(SoundEngine& engine, const Uint64 commandCount, std::vector<double>& latencies) {
+    const auto start = SDL_GetTicks();
+    while (SDL_GetTicks() - start < LATENCY_TIMEOUT_MS) {
+        if (engine.getMetrics().getCommandCount() != commandCount) {
+            latencies.push_back(engine.getMetrics().getLastCommandLatency() / 1000.0);
+            return true;
+        }
+        SDL_Delay(1);
+    }
+
+    return false;
+}
+
+static bool benchLatency(const std::vector<std::shared_ptr<File>>& files, const bool lowLatency, Latency& latency) {
+    auto settings = std::shared_ptr<Settings>(new Settings());
+    settings->putBool(KEY_APP_LOUDNESS_NORMALIZATION, false);
+
+    SoundEngine engine;
+    if (!engine.setup(DATA_PATH, "", settings, lowLatency)) {
+        fprintf(stderr, "%s\n", engine.getError().c_str());
+        return false;
+    }
+
+    for (const auto& file : files) {
+        auto commandCount = engine.getMetrics().getCommandCount();
+        if (!engine.load(file, settings, 0)) {
+            continue;
+        }
+        engine.play();
+        latency.files++;
+        if (!waitCommand(engine, commandCount, latency.loads)) {
+            fprintf(stderr, "%s: no sound after load\n", file->getPath().c_str());
+        }
+
+        // Let the read ahead settle before skipping, like a listener would
+        SDL_Delay(LATENCY_PLAY_MS);
+        commandCount = engine.getMetrics().getCommandCount();
+        if (engine.nextTrack() && !waitCommand(engine, commandCount, latency.nextTracks)) {
+            fprintf(stderr, "%s: no sound after next track\n", file->getPath().c_str());
+        }
+        engine.stop();
+    }
+
+    AudioMetrics::Snapshot snapshot;
+    engine.getMetrics().getSnapshot(snapshot);
+    latency.underruns = snapshot.underruns;
+    latency.readAhead = snapshot.readAhead;
+
+    engine.cleanup();
+    return true;
+}
+
+static int runLatency(const std::string corpusPath, const std::vector<FileSystem::Entry>& entries, LocalFileSystem& fileSystem) {
+    // The disk driver writing to /dev/null consume at the real device pace
+    SDL_setenv("SDL_AUDIODRIVER", "disk", 1);
+    SDL_setenv("SDL_DISKAUDIOFILE", "/dev/null", 1);
+    if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_TIMER) < 0) {
+        fprintf(stderr, "SDL_Init: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    std::vector<std::shared_ptr<File>> files;
+    for (const auto& entry : entries) {
+        if (const auto file = fileSystem.getFile(std::filesystem::path(corpusPath).append(entry.name));
+            !entry.folder && file != nullptr) {
+
+            files.push_back(file);
+        }
+    }
+
+    fprintf(stdout, "%-12s %6s %10s %10s %10s %10s %10s %10s %10s\n",
+        "mode", "files", "load p50", "load p99", "load max", "next p50", "next p99", "underruns", "read ahead");
+
+    for (auto lowLatency=0; lowLatency<2; lowLatency++) {
+        Latency latency;
+        if (!benchLatency(files, lowLatency == 1, latency)) {
+            continue;
+        }
+
+        const auto loadMax = latency.loads.empty() ? 0 : *std::max_element(latency.loads.begin(), latency.loads.end());
+        fprintf(stdout, "%-12s %6d %8.1fms %8.1fms %8.1fms %8.1fms %8.1fms %10llu %8.0fms\n",
+            lowLatency ? "low latency" : "default", latency.files,
+            getPercentile(latency.loads, 0.50), getPercentile(latency.loads, 0.99), loadMax,
+            getPercentile(latency.nextTracks, 0.50), getPercentile(latency.nextTracks, 0.99),
+            (unsigned long long) latency.underruns, latency.readAhead);
+    }
+
+    SDL_Quit();
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    auto seconds = 30;
+    auto chunkFrames = 2048;
+    auto measureLatency = false;
+    std::string corpusPath;
+
+    for (auto i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-l") == 0) {
+            measureLatency = true;
+        } else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i+1 < argc) {
+            chunkFrames = atoi(argv[++i]);
+        } else if (argv[i][0] == '-' || !corpusPath.empty()) {
+            usage();
+            return -1;
+        } else {
+            corpusPath = argv[i];
+        }
+    }
+
+    LocalFileSystem fileSystem("/");
+    std::vector<FileSystem::Entry> entries;
+    if (corpusPath.empty() || seconds < 1 || chunkFrames < 1 || !fileSystem.navigate(corpusPath, entries)) {
+        usage();
+        return -1;
+    }
+
+    if (measureLatency) {
+        return runLatency(corpusPath, entries, fileSystem);
+    }
+
+    const auto decoderList = DecoderFactory(DATA_PATH).createList();
+    DecoderRegistry registry;
+    registry.setup(decoderList);
+    std::map<std::string, std::map<std::string, Measure>> measures;
+
+    for (const auto& entry : entries) {
+        if (entry.folder) {
+            continue;
+        }
+
+        const auto file = fileSystem.getFile(std::filesystem::path(corpusPath).append(entry.name));
+        const auto content = file->getContent();
+        const auto index = content != nullptr ? registry.find(file->getPath(), content->getView()) : -1;
+        if (index < 0) {
+            continue;
+        }
+        const auto decoder = decoderList[index];
+
+        for (const auto& combination : getCombinations(decoder->getName())) {
+            // Fresh settings, only the combination differ from defaults
+            auto settings = std::shared_ptr<Settings>(new Settings());
+            for (const auto& setting : combination.intSettings) {
+                settings->putInt(setting.first, setting.second);
+            }
+            for (const auto& setting : combination.boolSettings) {
+                settings->putBool(setting.first, setting.second);
+            }
+
+            auto& measure = measures[decoder->getName()][combination.name];
+            if (!benchFile(decoder, content->getView(), settings, seconds, chunkFrames, measure)) {
+                fprintf(stderr, "%s: %s\n", entry.name.c_str(), decoder->getError().c_str());
+            }
+        }
+        fprintf(stderr, "%s done\n", entry.name.c_str());
+    }
+
+    fprintf(stdout, "%-10s %-32s %6s %10s %12s %10s %10s %10s\n",
+        "decoder", "settings", "files", "seconds", "samples/s", "realtime", "p50 us", "p99 us");
+
+    for (auto& [decoderName, combinations] : measures) {
+        for (auto& [combinationName, measure] : combinations) {
+            const auto samplesPerSecond = measure.renderTime > 0 ? measure.frames / measure.renderTime : 0;
+            const auto realtimeFactor = measure.renderTime > 0 ? measure.seconds / measure.renderTime : 0;
+            fprintf(stdout, "%-10s %-32s %6d %10.1f %12.0f %9.1fx %10.1f %10.1f\n",
+                decoderName.c_str(), combinationName.c_str(), measure.files, measure.seconds,
+                samplesPerSecond, realtimeFactor,
+                getPercentile(measure.callTimes, 0.50) * 1000000.0,
+                getPercentile(measure.callTimes, 0.99) * 1000000.0);
+        }
+    }
+
+    return 0;
+}
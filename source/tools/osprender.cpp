@@ -0,0 +1,135 @@
+// Offline renderer: decode songs to wav files as fast as possible.
+// osp-render [-j workers] [-l seconds] [-s] [-o directory] <file|directory>...
+
+#include "../offlinerenderer.h"
+#include "../settings.h"
+#include "../app_settings_strings.h"
+#include "../filesystem/local/localfilesystem.h"
+#include "../platform.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <SDL2/SDL_cpuinfo.h>
+
+static void usage() {
+    fprintf(stderr, "usage: osp-render [-j workers] [-l seconds] [-s] [-o directory] <file|directory>...\n"
+                    "  -j  number of parallel workers (default: cpu count)\n"
+                    "  -l  maximum duration of a song in seconds (default: 180)\n"
+                    "  -s  render every sub tunes in their own file\n"
+                    "  -o  output directory (default: current directory)\n");
+}
+
+static void makeOutputsUnique(std::vector<OfflineRenderer::Job>& jobs) {
+    // Songs of the same name in several folders or with several extensions, and sub
+    // tune suffixes matching another song name, would overwrite each other
+    std::unordered_set<std::string> outputs;
+    for (auto& job : jobs) {
+        const auto stem = job.output.stem().string();
+        for (auto count=2; !outputs.insert(job.output.string()).second; count++) {
+            job.output.replace_filename(std::string(stem).append("-").append(std::to_string(count)).append(".wav"));
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    auto workerCount = SDL_GetCPUCount();
+    auto maxDuration = 180;
+    auto allTracks = false;
+    std::filesystem::path outputPath = ".";
+    std::vector<std::string> inputs;
+
+    for (auto i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i+1 < argc) {
+            workerCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            maxDuration = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i+1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0) {
+            allTracks = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return -1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (inputs.empty() || workerCount < 1 || maxDuration < 1) {
+        usage();
+        return -1;
+    }
+
+    // Decoders settings are shared with the player, they are never saved from here
+    auto settings = std::shared_ptr<Settings>(new Settings());
+    settings->load("config.cfg");
+    if (allTracks) {
+        settings->putBool(KEY_APP_ALWAYS_START_FIRST_TUNE, true);
+    }
+
+    OfflineRenderer renderer(DATA_PATH, settings, workerCount);
+    renderer.setMaxDuration(maxDuration);
+
+    // Build the job list from files and directories content
+    LocalFileSystem fileSystem("/");
+    std::vector<OfflineRenderer::Job> jobs;
+    const auto addJob = [&](const std::filesystem::path path) {
+        const auto file = fileSystem.getFile(path);
+        if (!renderer.canRender(file)) {
+            return;
+        }
+
+        jobs.push_back({
+            .file = file,
+            .track = allTracks ? OfflineRenderer::ALL_TRACKS : OfflineRenderer::DEFAULT_TRACK,
+            .output = std::filesystem::path(outputPath).append(path.stem().string().append(".wav"))
+        });
+    };
+
+    for (const auto& input : inputs) {
+        std::vector<FileSystem::Entry> entries;
+        if (std::filesystem::is_directory(input) && fileSystem.navigate(input, entries)) {
+            for (const auto& entry : entries) {
+                if (!entry.folder) {
+                    addJob(std::filesystem::path(input).append(entry.name));
+                }
+            }
+        } else {
+            addJob(input);
+        }
+    }
+
+    if (allTracks) {
+        jobs = renderer.expandTracks(jobs);
+    }
+    makeOutputsUnique(jobs);
+
+    fprintf(stdout, "Rendering %zu song(s) with %d worker(s)\n", jobs.size(), renderer.getWorkerCount());
+
+    auto failures = 0;
+    auto totalSeconds = 0.0;
+    const auto startTime = SDL_GetPerformanceCounter();
+    renderer.render(jobs, [&](const OfflineRenderer::Result& result) {
+        if (!result.success) {
+            failures++;
+            fprintf(stderr, "%s: %s\n", result.job.file->getPath().c_str(), result.error.c_str());
+            return;
+        }
+
+        const auto seconds = (double) result.frames / result.frequency;
+        totalSeconds += seconds;
+        fprintf(stdout, "%s -> %s: %.1f s in %.2f s (x%.1f)\n", result.job.file->getPath().c_str(),
+            result.job.output.c_str(), seconds, result.elapsed, seconds / std::max(result.elapsed, 0.000001));
+    });
+
+    const auto elapsed = (double) (SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+    fprintf(stdout, "Done: %.1f s of sound in %.2f s (x%.1f), %d failure(s)\n",
+        totalSeconds, elapsed, totalSeconds / std::max(elapsed, 0.000001), failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -4,6 +4,7 @@
 #include "../../strings.h"
 
 ExplorerFrame::ExplorerFrame() {
+    mSearchQuery[0] = '\0';
 }
 
 ExplorerFrame::~ExplorerFrame() {
@@ -15,7 +16,8 @@ void ExplorerFrame::renderPath(const FrameData& frameData) {
 }
 
 void ExplorerFrame::renderExplorer(const FrameData& frameData,
-    const std::function<void (FileSystem::Entry)>& onItemClick) {
+    const std::function<void (FileSystem::Entry)>& onItemClick,
+    const std::function<void (FileSystem::Entry)>& onItemEnqueue) {
     
     const auto tableSize = ImVec2(0, 0);
     const auto tableFlags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_ScrollFreezeTopRow | ImGuiTableFlags_RowBg
@@ -33,10 +35,10 @@ void ExplorerFrame::renderExplorer(const FrameData& frameData,
 
     char temp[256];
     ImGuiListClipper clipper;
-    clipper.Begin(frameData.listing.size());
+    clipper.Begin(frameData.listing->size());
     while (clipper.Step()) {
         for (auto row=clipper.DisplayStart; row<clipper.DisplayEnd; row++) {
-            const auto item = frameData.listing[row];
+            const auto& item = (*frameData.listing)[row];
             ImGui::TableNextRow();
 
             ImGui::TableSetColumnIndex(0);
@@ -44,6 +46,12 @@ void ExplorerFrame::renderExplorer(const FrameData& frameData,
             if (ImGui::Selectable(temp, item.name == frameData.selectedItemName, ImGuiSelectableFlags_SpanAllColumns)) {
                 onItemClick(item);
             }
+            if (!item.folder && ImGui::BeginPopupContextItem()) {
+                if (ImGui::MenuItem(STR_MENU_ITEM_ADD_TO_QUEUE)) {
+                    onItemEnqueue(item);
+                }
+                ImGui::EndPopup();
+            }
 
             ImGui::TableSetColumnIndex(1);
             if (!item.folder) {
@@ -55,11 +63,85 @@ void ExplorerFrame::renderExplorer(const FrameData& frameData,
     ImGui::EndTable();
 }
 
+bool ExplorerFrame::renderSearch(const FrameData& frameData,
+    const std::function<void (const std::string& query)>& onSearchChange) {
+
+    if (!frameData.canSearch) {
+        return false;
+    }
+
+    ImGui::SetNextItemWidth(-1.0f);
+    if (ImGui::InputTextWithHint("##search", ICON_MDI_MAGNIFY " " STR_SEARCH_LIBRARY, mSearchQuery, sizeof(mSearchQuery))) {
+        onSearchChange(mSearchQuery);
+    }
+    ImGui::Spacing();
+
+    return mSearchQuery[0] != '\0';
+}
+
+void ExplorerFrame::renderSearchResults(const FrameData& frameData,
+    const std::function<void (const LibraryIndexer::Record&)>& onSearchResultClick) {
+
+    const auto tableSize = ImVec2(0, 0);
+    const auto tableFlags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_ScrollFreezeTopRow | ImGuiTableFlags_RowBg
+     | ImGuiTableFlags_BordersHOuter | ImGuiTableFlags_BordersVOuter | ImGuiTableFlags_BordersVInner
+     | ImGuiTableFlags_Resizable | ImGuiTableFlags_BordersVFullHeight;
+
+    if (!ImGui::BeginTable("##searchTable", 2, tableFlags, tableSize)) {
+        ImGui::EndTable();
+        return;
+    }
+
+    ImGui::TableSetupColumn(STR_NAME, ImGuiTableColumnFlags_None, 0.60f);
+    ImGui::TableSetupColumn(STR_AUTHOR, ImGuiTableColumnFlags_None, 0.40f);
+    ImGui::TableAutoHeaders();
+
+    if (frameData.searchResults == nullptr) {
+        ImGui::EndTable();
+        return;
+    }
+
+    char temp[512];
+    ImGuiListClipper clipper;
+    clipper.Begin(frameData.searchResults->size());
+    while (clipper.Step()) {
+        for (auto row=clipper.DisplayStart; row<clipper.DisplayEnd; row++) {
+            const auto& record = (*frameData.searchResults)[row];
+            const auto slash = record.path.rfind('/');
+            const auto name = slash == std::string::npos ? record.path.c_str() : record.path.c_str() + slash + 1;
+            ImGui::TableNextRow();
+
+            // Same label for two songs would share the selection, the row is part of the id
+            ImGui::TableSetColumnIndex(0);
+            if (record.title.empty()) {
+                snprintf(temp, sizeof(temp), "%s %s##%d", ICON_MDI_FILE, name, row);
+            } else {
+                snprintf(temp, sizeof(temp), "%s %s - %s##%d", ICON_MDI_FILE, record.title.c_str(), name, row);
+            }
+            if (ImGui::Selectable(temp, false, ImGuiSelectableFlags_SpanAllColumns)) {
+                onSearchResultClick(record);
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%s", record.path.c_str());
+            }
+
+            ImGui::TableSetColumnIndex(1);
+            ImGui::TextUnformatted(record.author.c_str());
+        }
+    }
+    ImGui::EndTable();
+}
+
 void ExplorerFrame::render(const FrameData& frameData,
-    const std::function<void (FileSystem::Entry)>& onItemClick) {
+    const std::function<void (FileSystem::Entry)>& onItemClick,
+    const std::function<void (FileSystem::Entry)>& onItemEnqueue,
+    const std::function<void (const std::string& query)>& onSearchChange,
+    const std::function<void (const LibraryIndexer::Record&)>& onSearchResultClick) {
     
     renderPath(frameData);
-    if (frameData.isWorking) {
+    if (renderSearch(frameData, onSearchChange)) {
+        renderSearchResults(frameData, onSearchResultClick);
+    } else if (frameData.isWorking) {
         // Using a little hack to make font bigger
         auto& io = ImGui::GetIO();
         const auto savedScale = io.FontDefault->Scale;
@@ -80,7 +162,7 @@ void ExplorerFrame::render(const FrameData& frameData,
         io.FontDefault->Scale = savedScale;
         ImGui::PopFont();
     } else {
-        renderExplorer(frameData, onItemClick);
+        renderExplorer(frameData, onItemClick, onItemEnqueue);
     }
 }
 
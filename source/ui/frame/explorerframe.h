@@ -1,32 +1,47 @@
 #pragma once
 
 #include "../../filesystem/filesystem.h"
+#include "../../libraryindexer.h"
 
 #include <filesystem>
 #include <vector>
 #include <functional>
+#include <memory>
 
 class ExplorerFrame {
 
     public:
         struct FrameData {
             std::filesystem::path currentPath;
-            std::vector<FileSystem::Entry> listing;
+            std::shared_ptr<const std::vector<FileSystem::Entry>> listing;
             std::string selectedItemName;
             bool isWorking;
+            bool canSearch;
+            std::shared_ptr<const std::vector<LibraryIndexer::Record>> searchResults;
         };
 
         ExplorerFrame();
         virtual ~ExplorerFrame();
 
         void render(const FrameData& frameData,
-            const std::function<void (FileSystem::Entry)>& onItemClick);
+            const std::function<void (FileSystem::Entry)>& onItemClick,
+            const std::function<void (FileSystem::Entry)>& onItemEnqueue,
+            const std::function<void (const std::string& query)>& onSearchChange,
+            const std::function<void (const LibraryIndexer::Record&)>& onSearchResultClick);
 
     private:
+        char mSearchQuery[256];
+
         ExplorerFrame(const ExplorerFrame& copy);
 
+        bool renderSearch(const FrameData& frameData,
+            const std::function<void (const std::string& query)>& onSearchChange);
+        void renderSearchResults(const FrameData& frameData,
+            const std::function<void (const LibraryIndexer::Record&)>& onSearchResultClick);
+
         void renderPath(const FrameData& frameData);
         void renderExplorer(const FrameData& frameData,
-            const std::function<void (FileSystem::Entry)>& onItemClick);
+            const std::function<void (FileSystem::Entry)>& onItemClick,
+            const std::function<void (FileSystem::Entry)>& onItemEnqueue);
         
 };
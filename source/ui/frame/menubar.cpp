@@ -58,6 +58,31 @@ void MenuBar::render(const MenuBarData& menuBarData,
         ImGui::EndMenu();
     }
         
+    if (ImGui::BeginMenu(STR_MENU_ITEM_PLAYBACK)) {
+        if (ImGui::MenuItem(STR_MENU_ITEM_SHUFFLE, nullptr, menuBarData.shuffle, true)) {
+            onMenuAtion(TOGGLE_SHUFFLE);
+        }
+        if (ImGui::BeginMenu(STR_MENU_ITEM_REPEAT)) {
+            if (ImGui::MenuItem(STR_MENU_ITEM_REPEAT_OFF, nullptr, menuBarData.repeat == PlayQueue::REPEAT_OFF, true)) {
+                onMenuAtion(REPEAT_OFF);
+            }
+            if (ImGui::MenuItem(STR_MENU_ITEM_REPEAT_ALL, nullptr, menuBarData.repeat == PlayQueue::REPEAT_ALL, true)) {
+                onMenuAtion(REPEAT_ALL);
+            }
+            if (ImGui::MenuItem(STR_MENU_ITEM_REPEAT_ONE, nullptr, menuBarData.repeat == PlayQueue::REPEAT_ONE, true)) {
+                onMenuAtion(REPEAT_ONE);
+            }
+            ImGui::EndMenu();
+        }
+
+        ImGui::Separator();
+
+        if (ImGui::MenuItem(STR_MENU_ITEM_CLEAR_QUEUE, nullptr, false, menuBarData.queueSize > 0)) {
+            onMenuAtion(CLEAR_QUEUE);
+        }
+        ImGui::EndMenu();
+    }
+
     if (ImGui::BeginMenu(STR_MENU_ITEM_HELP)) {
         if (ImGui::MenuItem(STR_METRICS_WINDOW_TITLE, nullptr, false, true)) {
             onMenuAtion(SHOW_METRICS);
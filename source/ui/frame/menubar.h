@@ -2,6 +2,7 @@
 
 #include "../../imgui/imgui.h"
 #include "../../filemanager.h"
+#include "../../playqueue.h"
 #include "../../settings.h"
 #include "../frame.h"
 
@@ -17,6 +18,11 @@ class MenuBar : public Frame {
             SHOW_SETTINGS,
             SHOW_ABOUT,
             SHOW_METRICS,
+            TOGGLE_SHUFFLE,
+            REPEAT_OFF,
+            REPEAT_ALL,
+            REPEAT_ONE,
+            CLEAR_QUEUE,
             QUIT
         };
 
@@ -25,6 +31,9 @@ class MenuBar : public Frame {
             FileManager::State fmState;
             bool itemShowWorkspaceCheked;
             std::shared_ptr<Settings> settings;
+            bool shuffle;
+            PlayQueue::Repeat repeat;
+            size_t queueSize;
         };
 
         MenuBar();
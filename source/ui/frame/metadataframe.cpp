@@ -11,6 +11,7 @@ MetaDataFrame::~MetaDataFrame() {
 }
 
 void MetaDataFrame::renderDiskInformation(const FrameData& frameData) {
+    const auto& metaData = *frameData.metaData;
     ImGui::NewLine();
     ImGui::TextUnformatted(STR_DISK_INFORMATION);
     ImGui::SeparatorEx(ImGuiSeparatorFlags_Horizontal);
@@ -19,39 +20,39 @@ void MetaDataFrame::renderDiskInformation(const FrameData& frameData) {
     const auto& style = ImGui::GetStyle();
     const auto rightMargin = ((ImGui::GetWindowContentRegionWidth()/2) + style.FramePadding.x) * 0.33f;
 
-    if (!frameData.metaData.diskInformation.title.empty()) {
+    if (!metaData.diskInformation.title.empty()) {
         ImGui::TextUnformatted(STR_TITLE);
         ImGui::SameLine(rightMargin);
-        ImGui::TextUnformatted(frameData.metaData.diskInformation.title.c_str());
+        ImGui::TextUnformatted(metaData.diskInformation.title.c_str());
     }
 
-    if (!frameData.metaData.diskInformation.ripper.empty()) {
+    if (!metaData.diskInformation.ripper.empty()) {
         ImGui::TextUnformatted(STR_RIPPER);
         ImGui::SameLine(rightMargin);
-        ImGui::TextUnformatted(frameData.metaData.diskInformation.ripper.c_str());
+        ImGui::TextUnformatted(metaData.diskInformation.ripper.c_str());
     }
 
-    if (!frameData.metaData.diskInformation.converter.empty()) {
+    if (!metaData.diskInformation.converter.empty()) {
         ImGui::TextUnformatted(STR_CONVERTER);
         ImGui::SameLine(rightMargin);
-        ImGui::TextUnformatted(frameData.metaData.diskInformation.converter.c_str());
+        ImGui::TextUnformatted(metaData.diskInformation.converter.c_str());
     }
 
-    if (!frameData.metaData.diskInformation.copyright.empty()) {
+    if (!metaData.diskInformation.copyright.empty()) {
         ImGui::TextUnformatted(STR_COPYRIGHT);
         ImGui::SameLine(rightMargin);
-        ImGui::TextUnformatted(frameData.metaData.diskInformation.copyright.c_str());
+        ImGui::TextUnformatted(metaData.diskInformation.copyright.c_str());
     }
 
-    if (frameData.metaData.diskInformation.trackCount > 0) {
-        sprintf(temp, "%d", frameData.metaData.diskInformation.trackCount);    
+    if (metaData.diskInformation.trackCount > 0) {
+        sprintf(temp, "%d", metaData.diskInformation.trackCount);    
         ImGui::TextUnformatted(STR_TRACK_COUNT);
         ImGui::SameLine(rightMargin);
         ImGui::TextUnformatted(temp);
     }
 
-    if (frameData.metaData.diskInformation.duration > 0) {
-        sprintf(temp, "%d:%02d", frameData.metaData.diskInformation.duration / 60, frameData.metaData.diskInformation.duration % 60);    
+    if (metaData.diskInformation.duration > 0) {
+        sprintf(temp, "%d:%02d", metaData.diskInformation.duration / 60, metaData.diskInformation.duration % 60);    
         ImGui::TextUnformatted(STR_TOTAL_DURATION);
         ImGui::SameLine(rightMargin);
         ImGui::TextUnformatted(temp);
@@ -59,6 +60,7 @@ void MetaDataFrame::renderDiskInformation(const FrameData& frameData) {
 }
 
 void MetaDataFrame::renderTrackInformation(const FrameData& frameData) {
+    const auto& metaData = *frameData.metaData;
     ImGui::NewLine();
     ImGui::TextUnformatted(STR_TRACK_INFORMATION);
     ImGui::SeparatorEx(ImGuiSeparatorFlags_Horizontal);
@@ -71,50 +73,50 @@ void MetaDataFrame::renderTrackInformation(const FrameData& frameData) {
     char temp[32];
     const auto rightMargin = ImGui::GetWindowContentRegionWidth() * 0.33f;
 
-    if (!frameData.metaData.trackInformation.title.empty()) {
+    if (!metaData.trackInformation.title.empty()) {
         ImGui::TextUnformatted(STR_TITLE);
         ImGui::SameLine(rightMargin);
-        ImGui::TextUnformatted(frameData.metaData.trackInformation.title.c_str());
+        ImGui::TextUnformatted(metaData.trackInformation.title.c_str());
     }
 
-    if (!frameData.metaData.trackInformation.author.empty()) {
+    if (!metaData.trackInformation.author.empty()) {
         ImGui::TextUnformatted(STR_AUTHOR);
         ImGui::SameLine(rightMargin);
-        ImGui::TextUnformatted(frameData.metaData.trackInformation.author.c_str());
+        ImGui::TextUnformatted(metaData.trackInformation.author.c_str());
     }
 
-    if (!frameData.metaData.trackInformation.copyright.empty()) {
+    if (!metaData.trackInformation.copyright.empty()) {
         ImGui::TextUnformatted(STR_COPYRIGHT);
         ImGui::SameLine(rightMargin);
-        ImGui::TextUnformatted(frameData.metaData.trackInformation.copyright.c_str());
+        ImGui::TextUnformatted(metaData.trackInformation.copyright.c_str());
     }
 
-    if (frameData.metaData.diskInformation.trackCount > 1) {
-        sprintf(temp, "%d/%d", frameData.metaData.trackInformation.trackNumber, frameData.metaData.diskInformation.trackCount);    
+    if (metaData.diskInformation.trackCount > 1) {
+        sprintf(temp, "%d/%d", metaData.trackInformation.trackNumber, metaData.diskInformation.trackCount);    
         ImGui::TextUnformatted(STR_TRACK_NUMBER);
         ImGui::SameLine(rightMargin);
         ImGui::TextUnformatted(temp);
     }
 
-    if (frameData.metaData.trackInformation.position > -1) {
-        sprintf(temp, "%d:%02d", frameData.metaData.trackInformation.position / 60, frameData.metaData.trackInformation.position % 60);    
+    if (frameData.position > -1) {
+        sprintf(temp, "%d:%02d", frameData.position / 60, frameData.position % 60);    
         ImGui::TextUnformatted(STR_PLAY_TIME);
         ImGui::SameLine(rightMargin);
         ImGui::TextUnformatted(temp);
     } 
 
-    if (frameData.metaData.trackInformation.duration > 0) {
-        sprintf(temp, "%d:%02d", frameData.metaData.trackInformation.duration / 60, frameData.metaData.trackInformation.duration % 60);    
+    if (metaData.trackInformation.duration > 0) {
+        sprintf(temp, "%d:%02d", metaData.trackInformation.duration / 60, metaData.trackInformation.duration % 60);    
         ImGui::TextUnformatted(STR_DURATION);
         ImGui::SameLine(rightMargin);
         ImGui::TextUnformatted(temp);
     } 
 
-    if (!frameData.metaData.trackInformation.comment.empty()) {
+    if (!metaData.trackInformation.comment.empty()) {
         ImGui::NewLine();
         ImGui::TextUnformatted(STR_COMMENTS);
         ImGui::Separator();
-        ImGui::TextWrapped("%s", frameData.metaData.trackInformation.comment.c_str());
+        ImGui::TextWrapped("%s", metaData.trackInformation.comment.c_str());
     }
 
     ImGui::EndChild();
@@ -129,7 +131,7 @@ void MetaDataFrame::render(const FrameData& frameData) {
         return;
     }
 
-    if (frameData.metaData.hasDiskInformation) {
+    if (frameData.metaData->hasDiskInformation) {
         renderDiskInformation(frameData);
     }
     renderTrackInformation(frameData);
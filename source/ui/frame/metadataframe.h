@@ -3,12 +3,15 @@
 #include "../../decoder/decoder.h"
 #include "../../soundengine.h"
 
+#include <memory>
+
 class MetaDataFrame {
 
     public:
         struct FrameData {
             SoundEngine::State state;
-            Decoder::MetaData metaData;
+            std::shared_ptr<const Decoder::MetaData> metaData;
+            int position;
         };
 
         MetaDataFrame();
@@ -3,18 +3,27 @@
 #include "../../imgui/imgui.h"
 #include "../../strings.h"
 
-PlayerFrame::PlayerFrame() {
+#include <algorithm>
+#include <cstdio>
+
+const int PlayerFrame::DEFAULT_SEEK_RANGE = 300;
+
+PlayerFrame::PlayerFrame() :
+    mSeekPosition(0),
+    mSeekBarActive(false) {
 }
 
 PlayerFrame::~PlayerFrame() {
 }
 
-void PlayerFrame::renderTitleAndSeekBar(const FrameData& frameData) {
-    auto title = frameData.metaData.trackInformation.title.empty()
-        ? frameData.metaData.diskInformation.title.empty()
+void PlayerFrame::renderTitleAndSeekBar(const FrameData& frameData,
+    const std::function<void (int)>& onSeek) {
+    const auto& metaData = *frameData.metaData;
+    auto title = metaData.trackInformation.title.empty()
+        ? metaData.diskInformation.title.empty()
             ? STR_TRACK_NO_TITLE
-            : frameData.metaData.diskInformation.title.c_str()
-        : frameData.metaData.trackInformation.title.c_str();
+            : metaData.diskInformation.title.c_str()
+        : metaData.trackInformation.title.c_str();
 
     switch (frameData.state) {
         case SoundEngine::State::STARTED:
@@ -26,6 +35,34 @@ void PlayerFrame::renderTitleAndSeekBar(const FrameData& frameData) {
             break;
     }
     ImGui::Spacing();
+
+    const auto& track = metaData.trackInformation;
+    const auto playing = frameData.state == SoundEngine::State::STARTED
+        || frameData.state == SoundEngine::State::PAUSED;
+    if (!playing || !track.seekable) {
+        mSeekBarActive = false;
+        return;
+    }
+
+    // Without duration, extend the range by steps as the song goes on
+    const auto range = track.duration > 0
+        ? track.duration
+        : std::max(DEFAULT_SEEK_RANGE, (frameData.position / DEFAULT_SEEK_RANGE + 1) * DEFAULT_SEEK_RANGE);
+
+    // Keep the dragged position until released
+    if (!mSeekBarActive) {
+        mSeekPosition = std::clamp(frameData.position, 0, range);
+    }
+
+    char label[32];
+    snprintf(label, sizeof(label), STR_SEEK_POSITION, mSeekPosition / 60, mSeekPosition % 60, range / 60, range % 60);
+    ImGui::SetNextItemWidth(-1.0f);
+    ImGui::SliderInt("##seekBar", &mSeekPosition, 0, range, label);
+    mSeekBarActive = ImGui::IsItemActive();
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        onSeek(mSeekPosition);
+    }
+    ImGui::Spacing();
 }
 
 void PlayerFrame::renderButtonBar(const FrameData& frameData, bool disabled,
@@ -75,11 +112,12 @@ void PlayerFrame::renderButtonBar(const FrameData& frameData, bool disabled,
 }
 
 void PlayerFrame::render(const FrameData& frameData,
-    const std::function<void (ButtonId)>& onButtonClick) {
+    const std::function<void (ButtonId)>& onButtonClick,
+    const std::function<void (int)>& onSeek) {
     
     const auto disabled = frameData.state != SoundEngine::State::PAUSED
         && frameData.state != SoundEngine::State::STARTED;
     
-    renderTitleAndSeekBar(frameData);
+    renderTitleAndSeekBar(frameData, onSeek);
     renderButtonBar(frameData, disabled, onButtonClick);
 }
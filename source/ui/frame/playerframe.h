@@ -15,7 +15,8 @@ class PlayerFrame {
         struct FrameData {
             GLuint texture;
             SoundEngine::State state;
-            Decoder::MetaData metaData;
+            std::shared_ptr<const Decoder::MetaData> metaData;
+            int position;
             std::shared_ptr<SpriteCatalog> catalog;
         };
 
@@ -30,12 +31,20 @@ class PlayerFrame {
         virtual ~PlayerFrame();
 
         void render(const FrameData& frameData,
-            const std::function<void (ButtonId)>& onButtonClick);
+            const std::function<void (ButtonId)>& onButtonClick,
+            const std::function<void (int)>& onSeek);
 
     private:
+        // Seek range used when the track duration is unknown (in seconds)
+        static const int DEFAULT_SEEK_RANGE;
+
+        int mSeekPosition;
+        bool mSeekBarActive;
+
         PlayerFrame(const PlayerFrame& copy);
 
-        void renderTitleAndSeekBar(const FrameData& frameData);
+        void renderTitleAndSeekBar(const FrameData& frameData,
+            const std::function<void (int)>& onSeek);
         void renderButtonBar(const FrameData& frameData, bool disabled,
             const std::function<void (ButtonId)>& onButtonClick);
 
@@ -3,17 +3,81 @@
 #include "../../imgui/imgui.h"
 #include "../../strings.h"
 
+#include <cfloat>
+#include <cstdio>
+
 MetricsWindow::MetricsWindow() :
-    Window(STR_METRICS_WINDOW_TITLE) {
+    Window(STR_METRICS_WINDOW_TITLE),
+    mShowImGuiMetrics(false) {
 }
 
 MetricsWindow::~MetricsWindow() {
 }
 
-void MetricsWindow::render() {
+void MetricsWindow::render(const AudioMetrics& metrics, const std::function<void ()>& onReset,
+    const std::function<void ()>& onDump) {
+
     if (!mVisible) {
         return;
     }
-    
-    ImGui::ShowMetricsWindow(&mVisible);
+
+    ImGui::SetNextWindowSize(ImVec2(480.0f, 0.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin(STR_METRICS_WINDOW_TITLE, &mVisible, ImGuiWindowFlags_None)) {
+        ImGui::End();
+        return;
+    }
+
+    metrics.getSnapshot(mSnapshot);
+
+    ImGui::Text(STR_AUDIO_CALLBACKS, (unsigned long long) mSnapshot.callbacks, mSnapshot.callbackPeriod);
+    ImGui::Text(STR_AUDIO_UNDERRUNS, (unsigned long long) mSnapshot.underruns, (unsigned long long) mSnapshot.droppedBuffers);
+    ImGui::Text(STR_DECODER_CHUNKS, (unsigned long long) mSnapshot.decodedChunks, mSnapshot.realtimeFactor);
+    ImGui::Text(STR_READ_AHEAD_TARGET, mSnapshot.readAhead);
+    ImGui::Text(STR_COMMAND_LATENCY, mSnapshot.lastCommandLatency / 1000.0f, mSnapshot.maxCommandLatency / 1000.0f,
+        (unsigned long long) mSnapshot.commands);
+    ImGui::Separator();
+
+    // Callback time is scaled on the period, over it the device is starving
+    renderPlot(STR_CALLBACK_TIME, mSnapshot.callbackTimes, mSnapshot.maxCallbackTime, mSnapshot.callbackPeriod);
+    renderPlot(STR_CALLBACK_JITTER, mSnapshot.callbackJitters, mSnapshot.maxCallbackJitter, mSnapshot.callbackPeriod);
+    renderPlot(STR_BUFFER_FILL, mSnapshot.bufferFills, 100.0f, 100.0f);
+    renderPlot(STR_PROCESS_TIME, mSnapshot.processTimes, mSnapshot.maxProcessTime, mSnapshot.callbackPeriod);
+    ImGui::Separator();
+
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), STR_HISTOGRAM_RANGE, AudioMetrics::getBucketStart(AudioMetrics::HISTOGRAM_SIZE - 1));
+    ImGui::TextUnformatted(STR_CALLBACK_HISTOGRAM);
+    ImGui::PlotHistogram("##callbackHistogram", mSnapshot.callbackHistogram, AudioMetrics::HISTOGRAM_SIZE, 0, overlay,
+        0.0f, FLT_MAX, ImVec2(-1.0f, 60.0f));
+    ImGui::TextUnformatted(STR_PROCESS_HISTOGRAM);
+    ImGui::PlotHistogram("##processHistogram", mSnapshot.processHistogram, AudioMetrics::HISTOGRAM_SIZE, 0, overlay,
+        0.0f, FLT_MAX, ImVec2(-1.0f, 60.0f));
+    ImGui::Separator();
+
+    if (ImGui::Button(STR_RESET)) {
+        onReset();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(STR_DUMP_TO_FILE)) {
+        onDump();
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox(STR_SHOW_IMGUI_METRICS, &mShowImGuiMetrics);
+
+    ImGui::End();
+
+    if (mShowImGuiMetrics) {
+        ImGui::ShowMetricsWindow(&mShowImGuiMetrics);
+    }
+}
+
+void MetricsWindow::renderPlot(const char* label, const float* values, const float max, const float scaleMax) {
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), STR_PLOT_LAST_MAX, values[AudioMetrics::HISTORY_SIZE - 1], max);
+
+    ImGui::TextUnformatted(label);
+    ImGui::PushID(label);
+    ImGui::PlotLines("", values, AudioMetrics::HISTORY_SIZE, 0, overlay, 0.0f, scaleMax > 0.0f ? scaleMax : FLT_MAX,
+        ImVec2(-1.0f, 50.0f));
+    ImGui::PopID();
 }
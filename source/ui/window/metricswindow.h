@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../window.h"
+#include "../../audio/audiometrics.h"
 
+#include <functional>
 #include <string>
 
 class MetricsWindow : public Window {
@@ -10,9 +12,15 @@ class MetricsWindow : public Window {
         MetricsWindow();
         virtual ~MetricsWindow();
 
-        void render();
+        void render(const AudioMetrics& metrics, const std::function<void ()>& onReset,
+            const std::function<void ()>& onDump);
 
     private:
+        AudioMetrics::Snapshot mSnapshot;
+        bool mShowImGuiMetrics;
+
         MetricsWindow(const MetricsWindow& copy);
 
+        void renderPlot(const char* label, const float* values, const float max, const float scaleMax);
+
 };
@@ -18,7 +18,9 @@ SettingsWindow::~SettingsWindow() {
 }
 
 void SettingsWindow::renderOspSettingsTab(const WindowData& windowData,
-    const std::function<void (AppSetting, bool value)>& onToggleSetting) {
+    const std::function<void (AppSetting, bool value)>& onToggleSetting,
+    const std::function<void (int volume)>& onVolumeChanged,
+    const std::function<void (std::string key, int value)>& onIntSettingChanged) {
 
     if (ImGui::BeginTabItem(STR_APPLICATION "##applicationTab")) {
         bool mouseEmulationEnabled = windowData.settings->getBool(KEY_APP_MOUSE_EMULATION, APP_MOUSE_EMULATION_DEFAULT);
@@ -61,6 +63,58 @@ void SettingsWindow::renderOspSettingsTab(const WindowData& windowData,
             ImGui::SetTooltip(STR_TOOLTIP_SKIP_SUBTUNES);
         }
 
+        auto readAhead = windowData.settings->getInt(KEY_APP_READ_AHEAD, APP_READ_AHEAD_DEFAULT);
+        if (ImGui::Combo(STR_READ_AHEAD, &readAhead, "100 ms\0""200 ms\0""500 ms\0""1000 ms\0")) {
+            onIntSettingChanged(KEY_APP_READ_AHEAD, readAhead);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(STR_TOOLTIP_READ_AHEAD);
+        }
+
+        bool lowLatency = windowData.settings->getBool(KEY_APP_LOW_LATENCY, APP_LOW_LATENCY_DEFAULT);
+        if (ImGui::Checkbox(STR_LOW_LATENCY, &lowLatency)) {
+            onToggleSetting(LOW_LATENCY, lowLatency);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(STR_TOOLTIP_LOW_LATENCY);
+        }
+
+        bool libraryIndexing = windowData.settings->getBool(KEY_APP_LIBRARY_INDEXING, APP_LIBRARY_INDEXING_DEFAULT);
+        if (ImGui::Checkbox(STR_LIBRARY_INDEXING, &libraryIndexing)) {
+            onToggleSetting(LIBRARY_INDEXING, libraryIndexing);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(STR_TOOLTIP_LIBRARY_INDEXING);
+        }
+
+        auto volume = windowData.settings->getInt(KEY_APP_VOLUME, APP_VOLUME_DEFAULT);
+        if (ImGui::SliderInt(STR_VOLUME, &volume, 0, 100, "%d %%")) {
+            onVolumeChanged(volume);
+        }
+        // Heard while dragging, saved once released
+        if (ImGui::IsItemDeactivatedAfterEdit()) {
+            onIntSettingChanged(KEY_APP_VOLUME, volume);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(STR_TOOLTIP_VOLUME);
+        }
+
+        bool loudnessNormalization = windowData.settings->getBool(KEY_APP_LOUDNESS_NORMALIZATION, APP_LOUDNESS_NORMALIZATION_DEFAULT);
+        if (ImGui::Checkbox(STR_LOUDNESS_NORMALIZATION, &loudnessNormalization)) {
+            onToggleSetting(LOUDNESS_NORMALIZATION, loudnessNormalization);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(STR_TOOLTIP_LOUDNESS_NORMALIZATION);
+        }
+
+        auto crossfade = windowData.settings->getInt(KEY_APP_CROSSFADE, APP_CROSSFADE_DEFAULT);
+        if (ImGui::Combo(STR_CROSSFADE, &crossfade, "Off\0""1 s\0""2 s\0""5 s\0")) {
+            onIntSettingChanged(KEY_APP_CROSSFADE, crossfade);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(STR_TOOLTIP_CROSSFADE);
+        }
+
         ImGui::EndTabItem();
     }
 }
@@ -232,6 +286,7 @@ void SettingsWindow::renderDumbDecoderTab(const WindowData& windowData,
 
 void SettingsWindow::render(const WindowData& windowData,
     const std::function<void (AppSetting, bool value)>& onToggleSetting,
+    const std::function<void (int volume)>& onVolumeChanged,
     const std::function<void (std::string key, int value)>& onDecoderIntSettingChanged,
     const std::function<void (std::string key, bool value)>& onDecoderBoolSettingChanged) {
 
@@ -253,7 +308,7 @@ void SettingsWindow::render(const WindowData& windowData,
 
     auto tabBarFlags = ImGuiTabBarFlags_NoTooltip;
     if (ImGui::BeginTabBar("ospSettingsTab", tabBarFlags)) {
-        renderOspSettingsTab(windowData, onToggleSetting);
+        renderOspSettingsTab(windowData, onToggleSetting, onVolumeChanged, onDecoderIntSettingChanged);
         renderSc68DecoderTab(windowData, onDecoderIntSettingChanged, onDecoderBoolSettingChanged);
         renderSidplayDecoderTab(windowData, onDecoderIntSettingChanged, onDecoderBoolSettingChanged);
         renderGmeDecoderTab(windowData, onDecoderIntSettingChanged, onDecoderBoolSettingChanged);
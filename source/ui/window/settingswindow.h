@@ -14,7 +14,10 @@ class SettingsWindow : public Window {
             TOUCH_ENABLED,
             AUTOSKIP_UNSUPPORTED_FILES,
             SKIP_SUBTUNES,
-            ALWAYS_START_FIRST_TRACK
+            ALWAYS_START_FIRST_TRACK,
+            LOUDNESS_NORMALIZATION,
+            LOW_LATENCY,
+            LIBRARY_INDEXING
         };
 
         struct WindowData {
@@ -24,8 +27,11 @@ class SettingsWindow : public Window {
         SettingsWindow();
         virtual ~SettingsWindow();
 
+        // onVolumeChanged follows the volume slider while dragged, the setting is
+        // only reported changed once the slider is released
         void render(const WindowData& windowData,
             const std::function<void (AppSetting, bool value)>& onToggleSetting,
+            const std::function<void (int volume)>& onVolumeChanged,
             const std::function<void (std::string key, int value)>& onDecoderIntSettingChanged,
             const std::function<void (std::string key, bool value)>& onDecoderBoolSettingChanged);
 
@@ -33,7 +39,9 @@ class SettingsWindow : public Window {
         SettingsWindow(const SettingsWindow& copy);
 
         void renderOspSettingsTab(const WindowData& windowData,
-            const std::function<void (AppSetting, bool value)>& onToggleSetting);
+            const std::function<void (AppSetting, bool value)>& onToggleSetting,
+            const std::function<void (int volume)>& onVolumeChanged,
+            const std::function<void (std::string key, int value)>& onIntSettingChanged);
 
         void renderSc68DecoderTab(const WindowData& windowData,
             const std::function<void (std::string key, int value)>& onDecoderIntSettingChanged,